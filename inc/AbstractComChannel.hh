@@ -11,6 +11,9 @@
 
 #include <mutex>
 #include <stdexcept>
+#include <string>
+#include <string_view>
+#include "ProtocolMessages.hh"
 
 /*!
  * \brief Definiuje interfejs kanału komunikacyjnego z serwerem graficznym.
@@ -54,9 +57,79 @@ public:
      *  Udostępnia mutex w trybie modyfikacji.
      *  Jest to przydatne, gdy planowany jest inny typ zamknięcie,
      *  np. poprzez klasę std::lock_guard, która daje możliwość
-     *  bezpieczniejszego zamknięcia.
+     *  bezpieczniejszego zamknięcia. Kanał może jednak odkładać
+     *  wysłanie poleceń do UnlockAccess(), dlatego do zamykania
+     *  na czas bloku należy używać klasy ChannelAccess.
      */
     virtual std::mutex& UseGuard() = 0;
+
+    /*!
+     * \brief Rozpoczyna ramkę animacji.
+     *
+     *  Od tej chwili, aż do wywołania EndFrame(), aktualizacje
+     *  stanu obiektów są gromadzone zamiast wysyłane od razu.
+     *  Wymaga zamkniętego dostępu do kanału.
+     */
+    virtual void BeginFrame() = 0;
+
+    /*!
+     * \brief Kończy ramkę animacji.
+     *
+     *  Wysyła wszystkie aktualizacje zgromadzone w trakcie ramki.
+     *  Wymaga zamkniętego dostępu do kanału.
+     */
+    virtual void EndFrame() = 0;
+
+    /*!
+     * \brief Przekazuje aktualizację stanu obiektu.
+     *
+     *  W trakcie ramki aktualizacja zastępuje wcześniejszą, jeszcze
+     *  niewysłaną aktualizację tego samego obiektu. Poza ramką
+     *  jest wysyłana natychmiast. Wymaga zamkniętego dostępu do kanału.
+     * \param[in] rObjName - nazwa aktualizowanego obiektu,
+     * \param[in] Message - kompletne polecenie dla serwera graficznego.
+     *            Jest kopiowane tylko wtedy, gdy nie może być wysłane od razu.
+     */
+    virtual void SendUpdate(const std::string &rObjName, std::string_view Message) = 0;
+
+    /*!
+     * \brief Dodaje obiekt na scenie serwera graficznego.
+     *
+     *  Sposób zakodowania polecenia zależy od wybranego formatu
+     *  połączenia (patrz WireFormat). Wymaga zamkniętego dostępu do kanału.
+     * \param[in] rObjName - nazwa dodawanego obiektu,
+     * \param[in] rDef - początkowy stan obiektu.
+     */
+    virtual void SendAddObj(const std::string &rObjName, const ObjDefinition &rDef) = 0;
+
+    /*!
+     * \brief Przekazuje aktualizację stanu obiektu w postaci strukturalnej.
+     *
+     *  Działa tak jak SendUpdate(), lecz polecenie koduje kanał,
+     *  zgodnie z wybranym formatem połączenia.
+     * \param[in] rObjName - nazwa aktualizowanego obiektu,
+     * \param[in] rUpd - zmienione pola stanu obiektu.
+     */
+    virtual void SendObjUpdate(const std::string &rObjName, const ObjUpdate &rUpd) = 0;
+};
+
+
+/*!
+ * \brief Zamyka dostęp do kanału na czas istnienia obiektu.
+ *
+ *  Wywołuje LockAccess() w konstruktorze i UnlockAccess() w destruktorze,
+ *  również przy wyjątku. W odróżnieniu od std::lock_guard na UseGuard()
+ *  pozwala kanałowi wysłać odłożone polecenia już po otwarciu dostępu.
+ */
+class ChannelAccess {
+    AbstractComChannel &ComChann;
+
+public:
+    explicit ChannelAccess(AbstractComChannel &rComChann): ComChann(rComChann) { ComChann.LockAccess(); }
+    ~ChannelAccess() { ComChann.UnlockAccess(); }
+
+    ChannelAccess(const ChannelAccess &) = delete;
+    ChannelAccess &operator=(const ChannelAccess &) = delete;
 };
 
 #endif
@@ -10,8 +10,15 @@
  */
 
 
+#include <chrono>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <string_view>
 #include "AbstractScene.hh"
 #include "AbstractComChannel.hh"
+#include "TokenCursor.hh"
 
 
  /*!
@@ -26,9 +33,13 @@
     virtual ~AbstractInterp4Command() {}
     
     /*!
-     * \brief Wyświetla postać bieżącego polecenia (nazwę oraz wartości parametrów)
+     * \brief Wypisuje postać bieżącego polecenia (nazwę oraz wartości parametrów)
+     *
+     * Tekst (bez znaku końca linii) trafia do podanego strumienia, dzięki
+     * czemu wywołujący może złożyć z wielu poleceń jeden komunikat loggera.
+     * \param[out] rOut - strumień, do którego zostaje wpisane polecenie.
      */
-     virtual void PrintCmd() const = 0;
+     virtual void PrintCmd(std::ostream &rOut) const = 0;
     /*!
      * \brief Wyświetla składnię polecenia
      */
@@ -64,6 +75,153 @@
       * \retval false - w przypadku przeciwnym.
       */
      virtual bool ReadParams(std::istream &rStrm_CmdsList) = 0;
+
+     /*!
+      * \brief Czyta wartości parametrów danego polecenia z wiersza skryptu.
+      *
+      * Czyta parametry bezpośrednio z tekstu skryptu, bez tworzenia
+      * strumienia. Domyślnie przekazuje pozostałą część wiersza (po
+      * podstawieniu stałych) do ReadParams(std::istream&), dzięki czemu
+      * wtyczki, które nie definiują tej metody, działają bez zmian.
+      * \param[in,out] rCursor - kursor ustawiony za nazwą polecenia.
+      * \retval true - operacja powiodła się,
+      * \retval false - w przypadku przeciwnym.
+      */
+     virtual bool ReadParams(TokenCursor &rCursor)
+     {
+       std::istringstream  Strm(rCursor.TakeRest());
+       return ReadParams(Strm);
+     }
+
+     /*!
+      * \brief Zapisuje wczytane parametry polecenia w postaci binarnej.
+      *
+      * Pozwala zapisać wczytany program w pamięci podręcznej (zob.
+      * ProgramCache.hh), dzięki czemu kolejne uruchomienie nie musi
+      * ponownie analizować skryptu. Do zapisu służą funkcje progcache::Put().
+      * \param[in,out] rBuffer - bufor, na którego koniec dopisywane są parametry.
+      * \retval true - parametry zostały zapisane,
+      * \retval false - polecenie nie obsługuje zapisu binarnego.
+      */
+     virtual bool SaveParams(std::string &/*rBuffer*/) const { return false; }
+
+     /*!
+      * \brief Odtwarza parametry polecenia zapisane przez SaveParams().
+      *
+      * Zastępuje ReadParams() przy wczytywaniu programu z pamięci podręcznej.
+      * \param[in,out] rData - dane, z których początku parametry są odczytywane i usuwane.
+      * \retval true - operacja powiodła się,
+      * \retval false - w przypadku przeciwnym.
+      */
+     virtual bool LoadParams(std::string_view &/*rData*/) { return false; }
+
+     /*!
+      * \brief Wiąże polecenie z obiektami sceny, na których działa.
+      *
+      * Wywoływana jednokrotnie podczas wczytywania programu, po ReadParams().
+      * Odnajduje obiekty po nazwach i zapamiętuje ich uchwyty, dzięki
+      * czemu wykonanie polecenia nie wymaga już przeszukiwania sceny.
+      * \param[in,out] rScn - scena zawierająca obiekty mobilne.
+      * \retval true - wszystkie obiekty zostały odnalezione,
+      * \retval false - w przypadku przeciwnym.
+      */
+     virtual bool BindObjects(AbstractScene &/*rScn*/) { return true; }
+
+     /*!
+      * \brief Informuje, czy polecenie jest animacją krokowaną w czasie.
+      *
+      * Polecenia będące animacjami nie są wykonywane przez ExecCmd(),
+      * lecz są krokowane przez wspólny zegar ramek interpretera.
+      * \retval true - polecenie jest animacją,
+      * \retval false - w przypadku przeciwnym.
+      */
+     virtual bool IsAnimation() const { return false; }
+
+     /*!
+      * \brief Informuje, czy polecenie jest jedynie odczekaniem zadanego czasu.
+      *
+      * Polecenia takie nie są wykonywane przez ExecCmd(). Interpreter
+      * rejestruje ich czas (zob. GetDelay_ms()) we wspólnym kole zegarowym,
+      * więc oczekiwanie nie zajmuje żadnego wątku.
+      * \retval true - polecenie jest odczekaniem,
+      * \retval false - w przypadku przeciwnym.
+      */
+     virtual bool IsDelay() const { return false; }
+
+     /*!
+      * \brief Udostępnia czas oczekiwania polecenia (w milisekundach).
+      */
+     virtual double GetDelay_ms() const { return 0; }
+
+     /*!
+      * \brief Przygotowuje animację do krokowania.
+      *
+      * Wywoływana jest jednokrotnie przed pierwszym wywołaniem Advance().
+      * \param[in,out]  rScn - scena zawierającą obiekty mobilne,
+      * \param[in,out]  rComChann - kanał komunikacyjny z serwerem graficznym.
+      * \retval true - operacja powiodła się,
+      * \retval false - w przypadku przeciwnym.
+      */
+     virtual bool StartAnimation(AbstractScene      &/*rScn*/,
+                                 AbstractComChannel &/*rComChann*/) { return false; }
+
+     /*!
+      * \brief Wykonuje jeden krok animacji.
+      *
+      * Metoda wywoływana jest raz na ramkę, przy zamkniętym dostępie
+      * do kanału komunikacyjnego. Nie może więc go ponownie zamykać.
+      * Zmienia jedynie stan obiektów; ich nowe położenie wysyła scena
+      * na końcu ramki (zob. AbstractScene::PublishChanges()).
+      * \param[in]      Dt_s - czas, który upłynął od poprzedniego kroku (w sekundach),
+      * \param[in,out]  rScn - scena zawierającą obiekty mobilne,
+      * \param[in,out]  rComChann - kanał komunikacyjny z serwerem graficznym.
+      * \retval true - animacja trwa nadal,
+      * \retval false - animacja została zakończona.
+      */
+     virtual bool Advance(double              /*Dt_s*/,
+                          AbstractScene      &/*rScn*/,
+                          AbstractComChannel &/*rComChann*/) { return false; }
+
+     /*!
+      * \brief Wykonuje całą animację we własnej pętli ramek.
+      *
+      * Służy poleceniom-animacjom wykonywanym przez ExecCmd(), tj. poza
+      * wspólnym zegarem interpretera (zob. AnimationScheduler). Wywołuje
+      * StartAnimation(), a następnie co ramkę Advance() z rzeczywistym
+      * czasem od poprzedniego kroku i wysyła zmiany sceny
+      * (AbstractScene::PublishChanges()), przy zamkniętym dostępie do kanału.
+      * \param[in,out]  rScn - scena zawierającą obiekty mobilne,
+      * \param[in,out]  rComChann - kanał komunikacyjny z serwerem graficznym,
+      * \param[in]      Fps - liczba ramek na sekundę.
+      * \retval true - animacja została wykonana,
+      * \retval false - nie udało się jej rozpocząć.
+      */
+     bool RunAnimationStandalone(AbstractScene      &rScn,
+                                 AbstractComChannel &rComChann,
+                                 unsigned int        Fps = 30)
+     {
+       if (!StartAnimation(rScn, rComChann)) return false;
+
+       using Clock = std::chrono::steady_clock;
+       const Clock::duration framePeriod = std::chrono::microseconds(1000000 / (Fps ? Fps : 30));
+       Clock::time_point lastStep = Clock::now();
+       Clock::time_point nextFrame = lastStep + framePeriod;
+       bool running = true;
+
+       while (running) {
+         std::this_thread::sleep_until(nextFrame);
+         nextFrame += framePeriod;
+
+         const Clock::time_point now = Clock::now();
+         const double dt = std::chrono::duration<double>(now - lastStep).count();
+         lastStep = now;
+
+         ChannelAccess access(rComChann);
+         running = Advance(dt, rScn, rComChann);
+         rScn.PublishChanges(rComChann);
+       }
+       return true;
+     }
   };
 
 
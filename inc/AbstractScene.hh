@@ -4,6 +4,8 @@
 #include "AbstractMobileObj.hh"
 #include <mutex>
 
+class AbstractComChannel;
+
 /*!
  * \class AbstractScene
  * \brief Abstract interface for managing a scene with mobile objects.
@@ -26,10 +28,27 @@ public:
     virtual void AddMobileObj(AbstractMobileObj* pMobObj) = 0;
 
     /*!
-     * \brief Provides access to the mutex for synchronization.
-     * \return Reference to the scene's mutex.
+     * \brief Provides the mutex guarding the state of one object.
+     *
+     * Commands lock only the objects they read or modify, so commands
+     * working on different objects never wait for each other. The
+     * reference may be cached for as long as the object stays in the scene.
+     * \param pMobObj Object of this scene, as returned by FindMobileObj().
+     * \return Reference to the object's mutex.
+     */
+    virtual std::mutex& GetObjMutex(const AbstractMobileObj* pMobObj) = 0;
+
+    /*!
+     * \brief Sends the state of every object that moved since the previous call.
+     *
+     * Commands only modify the objects; the scene recomputes the world
+     * transforms of the changed objects and of their descendants, and
+     * emits an update with the world transform of each object whose world
+     * transform changed.
+     * Must be called with the channel locked (see ChannelAccess).
+     * \param rComChann Channel receiving the updates.
      */
-    virtual std::mutex& GetMutex() = 0;
+    virtual void PublishChanges(AbstractComChannel& rComChann) = 0;
 };
 
 #endif
@@ -0,0 +1,271 @@
+#ifndef ANIMATIONSCHEDULER_HH
+#define ANIMATIONSCHEDULER_HH
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "AbstractInterp4Command.hh"
+#include "Logger.hh"
+#include "TimerWheel.hh"
+
+/*!
+ * \class AnimationScheduler
+ * \brief Central frame clock stepping all running animations.
+ *
+ * A single clock thread wakes up once per frame and calls
+ * AbstractInterp4Command::Advance() for every registered animation.
+ * Frames are scheduled against absolute deadlines, so the frame rate
+ * does not drift, and each animation receives the real time elapsed
+ * since its previous step. The whole frame is stepped while holding the
+ * access to the communication channel and enclosed in
+ * AbstractComChannel::BeginFrame()/EndFrame(), so one frame costs one
+ * lock handoff and one batched send regardless of the number of animations.
+ * After stepping, the scene publishes the objects moved in the frame
+ * (see AbstractScene::PublishChanges()).
+ *
+ * The same thread drives a TimerWheel with millisecond ticks, used for
+ * time-based waits such as Pause (see AddTimer()). Outstanding timers
+ * cost nothing until they expire; the thread sleeps until the next frame
+ * or the next timer, whichever comes first.
+ */
+class AnimationScheduler {
+private:
+    using Clock = std::chrono::steady_clock;
+
+    /*!
+     * \brief Single animation registered in the scheduler.
+     */
+    struct Entry {
+        AbstractInterp4Command* pCmd;   //!< Animated command
+        std::function<void()> OnDone;   //!< Called once the animation has finished
+        Clock::time_point LastStep;     //!< Time of the previous step
+    };
+
+    AbstractScene& rScn;                //!< Scene modified by the animations
+    AbstractComChannel& rComChann;      //!< Channel used to emit frame updates
+    Clock::duration FramePeriod;        //!< Time between two consecutive frames
+
+    /*!
+     * \brief Timer registered by AddTimer(), not yet in the wheel.
+     */
+    struct PendingTimer {
+        Clock::time_point Expiry;       //!< When the timer expires
+        std::function<void()> OnExpiry; //!< Called when the timer expires
+    };
+
+    std::vector<Entry> Active;          //!< Animations stepped by the clock thread
+    std::vector<Entry> Incoming;        //!< Animations registered since the last frame
+    std::vector<PendingTimer> IncomingTimers;   //!< Timers registered since the clock thread last woke up
+    TimerWheel Timers;                  //!< Pending timers, used by the clock thread only
+    const Clock::time_point TimeOrigin; //!< Time of tick 0 of the wheel
+    std::mutex Mutex;                   //!< Guards Incoming, IncomingTimers and Stopping
+    std::condition_variable Cond;       //!< Wakes up the idle clock thread
+    bool Stopping;                      //!< Set when the scheduler is being destroyed
+    std::thread ClockThread;            //!< Thread stepping the animations
+
+    /*!
+     * \brief Steps all active animations by one frame.
+     * \param Now Time of the current frame.
+     */
+    void StepFrame(Clock::time_point Now) {
+        std::vector<std::function<void()>> finished;
+
+        {
+            ChannelAccess access(rComChann);
+            rComChann.BeginFrame();
+
+            for (std::size_t i = 0; i < Active.size();) {
+                Entry& entry = Active[i];
+                const double dt = std::chrono::duration<double>(Now - entry.LastStep).count();
+                entry.LastStep = Now;
+
+                bool running = false;
+                try {
+                    running = entry.pCmd->Advance(dt, rScn, rComChann);
+                } catch (const std::exception& ex) {
+                    LOG_ERROR("Animation " << entry.pCmd->GetCmdName() << " failed: " << ex.what());
+                } catch (...) {
+                    LOG_ERROR("Animation " << entry.pCmd->GetCmdName() << " failed.");
+                }
+
+                if (running) {
+                    ++i;
+                    continue;
+                }
+
+                finished.push_back(std::move(entry.OnDone));
+                entry = std::move(Active.back());
+                Active.pop_back();
+            }
+
+            rScn.PublishChanges(rComChann);
+            rComChann.EndFrame();
+        }
+
+        // Completion callbacks may release waiting threads, run them without the channel lock.
+        for (auto& onDone : finished) {
+            if (onDone) onDone();
+        }
+    }
+
+    /*!
+     * \brief Number of whole ticks of the timer wheel elapsed at the given time.
+     */
+    TimerWheel::Tick ElapsedTicks(Clock::time_point Time) const {
+        if (Time <= TimeOrigin) return 0;
+        return static_cast<TimerWheel::Tick>(
+            std::chrono::duration_cast<std::chrono::milliseconds>(Time - TimeOrigin).count());
+    }
+
+    /*!
+     * \brief First tick of the timer wheel not earlier than the given time.
+     */
+    TimerWheel::Tick ExpiryTick(Clock::time_point Time) const {
+        const TimerWheel::Tick tick = ElapsedTicks(Time);
+        return FromTick(tick) < Time ? tick + 1 : tick;
+    }
+
+    /*!
+     * \brief Converts a tick of the timer wheel to a time.
+     */
+    Clock::time_point FromTick(TimerWheel::Tick Tick) const {
+        return TimeOrigin + std::chrono::milliseconds(Tick);
+    }
+
+    /*!
+     * \brief Main loop of the clock thread.
+     */
+    void ClockLoop() {
+        Clock::time_point nextFrame = Clock::now() + FramePeriod;
+        bool framesRunning = false;
+
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(Mutex);
+                for (;;) {
+                    if (Stopping) return;
+
+                    for (auto& timer : IncomingTimers) {
+                        Timers.Schedule(ExpiryTick(timer.Expiry), std::move(timer.OnExpiry));
+                    }
+                    IncomingTimers.clear();
+
+                    const bool animating = !Active.empty() || !Incoming.empty();
+                    if (animating && !framesRunning) {
+                        nextFrame = Clock::now() + FramePeriod;
+                    }
+                    framesRunning = animating;
+
+                    if (!framesRunning && Timers.Empty()) {
+                        Cond.wait(lock);
+                        continue;
+                    }
+
+                    // Sleep until the next frame or timer, unless new work which may need an earlier wakeup arrives
+                    Clock::time_point wakeUp = nextFrame;
+                    if (!Timers.Empty()) {
+                        const Clock::time_point timerWakeUp = FromTick(Timers.Now() + Timers.TicksToNextEvent());
+                        wakeUp = framesRunning ? std::min(nextFrame, timerWakeUp) : timerWakeUp;
+                    }
+                    const bool interrupted = Cond.wait_until(lock, wakeUp, [this, framesRunning]() {
+                        return Stopping || !IncomingTimers.empty() || (!framesRunning && !Incoming.empty());
+                    });
+                    if (!interrupted) break;
+                }
+
+                if (framesRunning && Clock::now() >= nextFrame) {
+                    for (auto& entry : Incoming) {
+                        Active.push_back(std::move(entry));
+                    }
+                    Incoming.clear();
+                }
+            }
+
+            const Clock::time_point now = Clock::now();
+
+            // Expired timers may release waiting threads, they run without any lock.
+            Timers.Advance(ElapsedTicks(now));
+
+            if (framesRunning && now >= nextFrame) {
+                nextFrame += FramePeriod;
+                if (now > nextFrame) {
+                    nextFrame = now + FramePeriod;  // Frames were missed, do not try to catch up
+                }
+                StepFrame(now);
+            }
+        }
+    }
+
+public:
+    /*!
+     * \brief Starts the clock thread.
+     * \param rScene Scene modified by the animations.
+     * \param rChannel Channel used by the animations to emit updates.
+     * \param Fps Number of frames per second.
+     */
+    AnimationScheduler(AbstractScene& rScene, AbstractComChannel& rChannel, unsigned int Fps = 30)
+        : rScn(rScene), rComChann(rChannel),
+          FramePeriod(std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / (Fps ? Fps : 30)))),
+          TimeOrigin(Clock::now()), Stopping(false) {
+        ClockThread = std::thread(&AnimationScheduler::ClockLoop, this);
+    }
+
+    AnimationScheduler(const AnimationScheduler&) = delete;
+    AnimationScheduler& operator=(const AnimationScheduler&) = delete;
+
+    /*!
+     * \brief Stops the clock thread.
+     *
+     * Animations which have not finished yet are abandoned.
+     */
+    ~AnimationScheduler() {
+        {
+            std::lock_guard<std::mutex> lock(Mutex);
+            Stopping = true;
+        }
+        Cond.notify_all();
+
+        if (ClockThread.joinable()) {
+            ClockThread.join();
+        }
+    }
+
+    /*!
+     * \brief Registers an animation.
+     *
+     * The command must have been prepared with
+     * AbstractInterp4Command::StartAnimation(). It is stepped from the
+     * next frame on until its Advance() returns false.
+     * \param pCmd The animated command.
+     * \param OnDone Called from the clock thread when the animation has finished.
+     */
+    void Add(AbstractInterp4Command* pCmd, std::function<void()> OnDone) {
+        {
+            std::lock_guard<std::mutex> lock(Mutex);
+            Incoming.push_back(Entry{pCmd, std::move(OnDone), Clock::now()});
+        }
+        Cond.notify_one();
+    }
+
+    /*!
+     * \brief Registers a one-shot timer.
+     *
+     * The timer has a resolution of one millisecond; it never expires early.
+     * \param Delay Time after which the timer expires.
+     * \param OnExpiry Called from the clock thread when the timer expires.
+     */
+    void AddTimer(Clock::duration Delay, std::function<void()> OnExpiry) {
+        {
+            std::lock_guard<std::mutex> lock(Mutex);
+            IncomingTimers.push_back(PendingTimer{Clock::now() + Delay, std::move(OnExpiry)});
+        }
+        Cond.notify_one();
+    }
+};
+
+#endif
@@ -0,0 +1,312 @@
+#ifndef BATCHKERNELS_HH
+#define BATCHKERNELS_HH
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <type_traits>
+#include "Vector3D.hh"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define APM_KERNELS_X86 1
+#endif
+
+/*!
+ * \file
+ * \brief Kernels converting the rotations of many objects per call.
+ *
+ * EulerToMatrices() composes roll, pitch and yaw into rotation matrices,
+ * MatricesToEuler() decomposes (world) rotation matrices back into them.
+ *
+ * The kernels work on arrays of Vector3D as on flat arrays of doubles.
+ * On x86 the AVX2 variant is selected at run time when the CPU supports
+ * it, otherwise the scalar variant is used. The variants are compiled
+ * with function target attributes, so the program itself is still built
+ * for the baseline architecture.
+ *
+ * The AVX2 variant evaluates sine, cosine and arc tangent with its own
+ * polynomials, so all results of one run come from the same variant
+ * (see EulerToMatrices()).
+ */
+namespace kernels {
+
+static_assert(sizeof(Vector3D) == 3 * sizeof(double) && std::is_standard_layout<Vector3D>::value,
+              "Vector3D arrays are processed as flat arrays of doubles");
+
+/*!
+ * \brief Instruction set used by the kernels.
+ */
+enum class Isa { Scalar, Avx2 };
+
+/*!
+ * \brief Returns the name of an instruction set, for diagnostics.
+ */
+inline const char* IsaName(Isa Set) {
+    switch (Set) {
+        case Isa::Avx2: return "avx2";
+        default: return "scalar";
+    }
+}
+
+/*!
+ * \brief Detects the best instruction set supported by the CPU (once).
+ */
+inline Isa ActiveIsa() {
+#ifdef APM_KERNELS_X86
+    static const Isa detected = [] {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return Isa::Avx2;
+        return Isa::Scalar;
+    }();
+    return detected;
+#else
+    return Isa::Scalar;
+#endif
+}
+
+namespace detail {
+
+#ifdef APM_KERNELS_X86
+/*!
+ * \brief Sine and cosine of four angles given in degrees.
+ *
+ * The angle is reduced exactly in degrees to the nearest multiple of 90,
+ * the rest (at most 45 degrees) is evaluated with the minimax polynomials
+ * of fdlibm's __kernel_sin/__kernel_cos. Angles beyond 1.9e11 degrees
+ * are not supported.
+ */
+__attribute__((target("avx2,fma")))
+inline void SinCosDegAvx2(__m256d Deg, __m256d& rSin, __m256d& rCos) {
+    const __m256d q = _mm256_round_pd(_mm256_mul_pd(Deg, _mm256_set1_pd(1.0 / 90.0)),
+                                      _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    const __m256d r = _mm256_mul_pd(_mm256_fnmadd_pd(q, _mm256_set1_pd(90.0), Deg), _mm256_set1_pd(M_PI / 180.0));
+    const __m256d z = _mm256_mul_pd(r, r);
+
+    __m256d ps = _mm256_set1_pd(1.58969099521155010221e-10);
+    ps = _mm256_fmadd_pd(ps, z, _mm256_set1_pd(-2.50507602534068634195e-08));
+    ps = _mm256_fmadd_pd(ps, z, _mm256_set1_pd(2.75573137070700676789e-06));
+    ps = _mm256_fmadd_pd(ps, z, _mm256_set1_pd(-1.98412698298579493134e-04));
+    ps = _mm256_fmadd_pd(ps, z, _mm256_set1_pd(8.33333333332248946124e-03));
+    ps = _mm256_fmadd_pd(ps, z, _mm256_set1_pd(-1.66666666666666324348e-01));
+    const __m256d sinR = _mm256_fmadd_pd(_mm256_mul_pd(r, z), ps, r);
+
+    __m256d pc = _mm256_set1_pd(-1.13596475577881948265e-11);
+    pc = _mm256_fmadd_pd(pc, z, _mm256_set1_pd(2.08757232129817482790e-09));
+    pc = _mm256_fmadd_pd(pc, z, _mm256_set1_pd(-2.75573143513906633035e-07));
+    pc = _mm256_fmadd_pd(pc, z, _mm256_set1_pd(2.48015872894767294178e-05));
+    pc = _mm256_fmadd_pd(pc, z, _mm256_set1_pd(-1.38888888888741095749e-03));
+    pc = _mm256_fmadd_pd(pc, z, _mm256_set1_pd(4.16666666666666019037e-02));
+    const __m256d cosR = _mm256_fmadd_pd(_mm256_mul_pd(z, z), pc,
+                                         _mm256_fnmadd_pd(_mm256_set1_pd(0.5), z, _mm256_set1_pd(1.0)));
+
+    // Quadrant q mod 4: odd quadrants swap sine and cosine, the signs follow from bit 1 of q and q + 1
+    const __m256i quadrant = _mm256_cvtepi32_epi64(_mm256_cvtpd_epi32(q));
+    const __m256d swap = _mm256_castsi256_pd(_mm256_cmpeq_epi64(
+        _mm256_and_si256(quadrant, _mm256_set1_epi64x(1)), _mm256_set1_epi64x(1)));
+    const __m256d sinSign = _mm256_castsi256_pd(_mm256_slli_epi64(
+        _mm256_and_si256(quadrant, _mm256_set1_epi64x(2)), 62));
+    const __m256d cosSign = _mm256_castsi256_pd(_mm256_slli_epi64(
+        _mm256_and_si256(_mm256_add_epi64(quadrant, _mm256_set1_epi64x(1)), _mm256_set1_epi64x(2)), 62));
+
+    rSin = _mm256_xor_pd(_mm256_blendv_pd(sinR, cosR, swap), sinSign);
+    rCos = _mm256_xor_pd(_mm256_blendv_pd(cosR, sinR, swap), cosSign);
+}
+
+/*!
+ * \brief Arc tangent of y/x for four pairs, in radians, as std::atan2 for pairs not both zero.
+ *
+ * The quotient is reduced to [0, 0.66] as in Cephes' atan and evaluated
+ * with its rational approximation. Both arguments being zero gives NaN.
+ */
+__attribute__((target("avx2,fma")))
+inline __m256d Atan2Avx2(__m256d Y, __m256d X) {
+    const __m256d signMask = _mm256_set1_pd(-0.0);
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256d t = _mm256_div_pd(Y, X);
+    const __m256d a = _mm256_andnot_pd(signMask, t);
+
+    const __m256d big = _mm256_cmp_pd(a, _mm256_set1_pd(2.41421356237309504880), _CMP_GT_OQ);   // tan(3*pi/8)
+    const __m256d mid = _mm256_andnot_pd(big, _mm256_cmp_pd(a, _mm256_set1_pd(0.66), _CMP_GT_OQ));
+    __m256d x = _mm256_blendv_pd(a, _mm256_div_pd(_mm256_sub_pd(a, one), _mm256_add_pd(a, one)), mid);
+    x = _mm256_blendv_pd(x, _mm256_div_pd(_mm256_set1_pd(-1.0), a), big);
+    __m256d y0 = _mm256_and_pd(mid, _mm256_set1_pd(M_PI / 4));
+    y0 = _mm256_blendv_pd(y0, _mm256_set1_pd(M_PI / 2), big);
+    __m256d more = _mm256_and_pd(mid, _mm256_set1_pd(0.5 * 6.123233995736765886130e-17));
+    more = _mm256_blendv_pd(more, _mm256_set1_pd(6.123233995736765886130e-17), big);
+
+    const __m256d z = _mm256_mul_pd(x, x);
+    __m256d p = _mm256_set1_pd(-8.750608600031904122785e-01);
+    p = _mm256_fmadd_pd(p, z, _mm256_set1_pd(-1.615753718733365076637e+01));
+    p = _mm256_fmadd_pd(p, z, _mm256_set1_pd(-7.500855792314704667340e+01));
+    p = _mm256_fmadd_pd(p, z, _mm256_set1_pd(-1.228866684490136173410e+02));
+    p = _mm256_fmadd_pd(p, z, _mm256_set1_pd(-6.485021904942025371773e+01));
+    __m256d q = _mm256_add_pd(z, _mm256_set1_pd(2.485846490142306297962e+01));
+    q = _mm256_fmadd_pd(q, z, _mm256_set1_pd(1.650270098316988542046e+02));
+    q = _mm256_fmadd_pd(q, z, _mm256_set1_pd(4.328810604912902668951e+02));
+    q = _mm256_fmadd_pd(q, z, _mm256_set1_pd(4.853903996359136964868e+02));
+    q = _mm256_fmadd_pd(q, z, _mm256_set1_pd(1.945506571482613964425e+02));
+    const __m256d r = _mm256_fmadd_pd(_mm256_mul_pd(x, z), _mm256_div_pd(p, q), x);
+    const __m256d atanT = _mm256_or_pd(_mm256_add_pd(y0, _mm256_add_pd(r, more)), _mm256_and_pd(t, signMask));
+
+    // Left half-plane, -0 included (y/-0 is -inf): add pi with the sign of y
+    const __m256d halfTurn = _mm256_or_pd(_mm256_set1_pd(M_PI), _mm256_and_pd(Y, signMask));
+    return _mm256_add_pd(atanT, _mm256_blendv_pd(_mm256_setzero_pd(), halfTurn, X));
+}
+
+/*!
+ * \brief Loads element K of four consecutive 3x3 matrices.
+ */
+__attribute__((target("avx2,fma")))
+inline __m256d Element4(const double* pR, int K) {
+    return _mm256_setr_pd(pR[K], pR[9 + K], pR[18 + K], pR[27 + K]);
+}
+
+/*!
+ * \brief Roll, pitch and yaw of four rotation matrices (see MatrixToEuler()).
+ * \param pR Row-major matrices of the four objects (36 doubles).
+ * \param pRotDeg Output, roll, pitch and yaw in degrees (12 doubles).
+ */
+__attribute__((target("avx2,fma")))
+inline void MatricesToEuler4Avx2(const double* pR, double* pRotDeg) {
+    const __m256d r0 = Element4(pR, 0), r3 = Element4(pR, 3), r6 = Element4(pR, 6);
+    const __m256d cp = _mm256_sqrt_pd(_mm256_fmadd_pd(r0, r0, _mm256_mul_pd(r3, r3)));
+    const __m256d lock = _mm256_cmp_pd(cp, _mm256_set1_pd(1e-12), _CMP_LT_OQ);
+    const __m256d negate = _mm256_set1_pd(-0.0);
+    const __m256d toDeg = _mm256_set1_pd(180.0 / M_PI);
+
+    alignas(32) double angles[3][4];
+    _mm256_store_pd(angles[0], _mm256_andnot_pd(lock, _mm256_mul_pd(Atan2Avx2(Element4(pR, 7), Element4(pR, 8)), toDeg)));
+    _mm256_store_pd(angles[1], _mm256_mul_pd(Atan2Avx2(_mm256_xor_pd(r6, negate), cp), toDeg));
+    _mm256_store_pd(angles[2], _mm256_mul_pd(_mm256_blendv_pd(Atan2Avx2(r3, r0),
+                                                              Atan2Avx2(_mm256_xor_pd(Element4(pR, 1), negate), Element4(pR, 4)), lock),
+                                             toDeg));
+
+    for (int obj = 0; obj < 4; ++obj) {
+        for (int k = 0; k < 3; ++k) pRotDeg[3 * obj + k] = angles[k][obj];
+    }
+}
+
+/*!
+ * \brief Rotation matrices of four objects (see EulerToMatrix()).
+ * \param pRotDeg Roll, pitch and yaw of the four objects (12 doubles).
+ * \param pR Output, 9 doubles per object (36 doubles).
+ */
+__attribute__((target("avx2,fma")))
+inline void EulerToMatrices4Avx2(const double* pRotDeg, double* pR) {
+    __m256d sr, cr, sp, cp, sy, cy;
+    SinCosDegAvx2(_mm256_setr_pd(pRotDeg[0], pRotDeg[3], pRotDeg[6], pRotDeg[9]), sr, cr);
+    SinCosDegAvx2(_mm256_setr_pd(pRotDeg[1], pRotDeg[4], pRotDeg[7], pRotDeg[10]), sp, cp);
+    SinCosDegAvx2(_mm256_setr_pd(pRotDeg[2], pRotDeg[5], pRotDeg[8], pRotDeg[11]), sy, cy);
+
+    const __m256d cysp = _mm256_mul_pd(cy, sp);
+    const __m256d sysp = _mm256_mul_pd(sy, sp);
+    alignas(32) double m[9][4];
+    _mm256_store_pd(m[0], _mm256_mul_pd(cy, cp));
+    _mm256_store_pd(m[1], _mm256_fmsub_pd(cysp, sr, _mm256_mul_pd(sy, cr)));
+    _mm256_store_pd(m[2], _mm256_fmadd_pd(cysp, cr, _mm256_mul_pd(sy, sr)));
+    _mm256_store_pd(m[3], _mm256_mul_pd(sy, cp));
+    _mm256_store_pd(m[4], _mm256_fmadd_pd(sysp, sr, _mm256_mul_pd(cy, cr)));
+    _mm256_store_pd(m[5], _mm256_fmsub_pd(sysp, cr, _mm256_mul_pd(cy, sr)));
+    _mm256_store_pd(m[6], _mm256_xor_pd(sp, _mm256_set1_pd(-0.0)));
+    _mm256_store_pd(m[7], _mm256_mul_pd(cp, sr));
+    _mm256_store_pd(m[8], _mm256_mul_pd(cp, cr));
+
+    for (int obj = 0; obj < 4; ++obj) {
+        for (int k = 0; k < 9; ++k) pR[9 * obj + k] = m[k][obj];
+    }
+}
+#endif
+
+} // namespace detail
+
+/*!
+ * \brief Composes roll, pitch and yaw (degrees) into a row-major rotation matrix Rz * Ry * Rx.
+ */
+inline void EulerToMatrix(const Vector3D& rRotDeg, double* pR) {
+    constexpr double degToRad = M_PI / 180.0;
+    const double cr = std::cos(rRotDeg[0] * degToRad), sr = std::sin(rRotDeg[0] * degToRad);
+    const double cp = std::cos(rRotDeg[1] * degToRad), sp = std::sin(rRotDeg[1] * degToRad);
+    const double cy = std::cos(rRotDeg[2] * degToRad), sy = std::sin(rRotDeg[2] * degToRad);
+
+    pR[0] = cy * cp; pR[1] = cy * sp * sr - sy * cr; pR[2] = cy * sp * cr + sy * sr;
+    pR[3] = sy * cp; pR[4] = sy * sp * sr + cy * cr; pR[5] = sy * sp * cr - cy * sr;
+    pR[6] = -sp;     pR[7] = cp * sr;                pR[8] = cp * cr;
+}
+
+/*!
+ * \brief Decomposes a row-major rotation matrix Rz * Ry * Rx into roll, pitch and yaw (degrees).
+ *
+ * Inverse of EulerToMatrix(), with the pitch in [-90, 90] and the roll
+ * and yaw in [-180, 180]. At a pitch of +-90 degrees only the sum (or
+ * difference) of roll and yaw is defined; the roll is then set to 0.
+ */
+inline Vector3D MatrixToEuler(const double* pR) {
+    constexpr double radToDeg = 180.0 / M_PI;
+    const double cp = std::sqrt(pR[0] * pR[0] + pR[3] * pR[3]);
+    const double pitch = std::atan2(-pR[6], cp) * radToDeg;
+    if (cp < 1e-12) {   // Gimbal lock
+        return Vector3D(0, pitch, std::atan2(-pR[1], pR[4]) * radToDeg);
+    }
+    return Vector3D(std::atan2(pR[7], pR[8]) * radToDeg, pitch, std::atan2(pR[3], pR[0]) * radToDeg);
+}
+
+/*!
+ * \brief Composes the rotation matrices of many objects, with the variant chosen by ActiveIsa().
+ *
+ * The AVX2 variant converts four objects per step and pads the last
+ * step, so an angle always gives the same matrix, wherever it is in the array.
+ * \param pRotDeg Roll, pitch and yaw of every object, in degrees.
+ * \param pR Output, 9 doubles (row-major matrix) per object.
+ * \param Count Number of objects.
+ */
+inline void EulerToMatrices(const Vector3D* pRotDeg, double* pR, std::size_t Count) {
+#ifdef APM_KERNELS_X86
+    if (ActiveIsa() == Isa::Avx2) {
+        const double* pIn = reinterpret_cast<const double*>(pRotDeg);
+        std::size_t i = 0;
+        for (; i + 4 <= Count; i += 4) detail::EulerToMatrices4Avx2(pIn + 3 * i, pR + 9 * i);
+        if (i < Count) {
+            double in[12] = {};
+            double out[36];
+            std::copy(pIn + 3 * i, pIn + 3 * Count, in);
+            detail::EulerToMatrices4Avx2(in, out);
+            std::copy(out, out + 9 * (Count - i), pR + 9 * i);
+        }
+        return;
+    }
+#endif
+    for (std::size_t i = 0; i < Count; ++i) EulerToMatrix(pRotDeg[i], pR + 9 * i);
+}
+
+/*!
+ * \brief Decomposes the rotation matrices of many objects, with the variant chosen by ActiveIsa().
+ *
+ * As EulerToMatrices(), the AVX2 variant pads the last step.
+ * \param pR Row-major matrices, 9 doubles per object.
+ * \param pRotDeg Output, roll, pitch and yaw of every object, in degrees (see MatrixToEuler()).
+ * \param Count Number of objects.
+ */
+inline void MatricesToEuler(const double* pR, Vector3D* pRotDeg, std::size_t Count) {
+#ifdef APM_KERNELS_X86
+    if (ActiveIsa() == Isa::Avx2) {
+        double* pOut = reinterpret_cast<double*>(pRotDeg);
+        std::size_t i = 0;
+        for (; i + 4 <= Count; i += 4) detail::MatricesToEuler4Avx2(pR + 9 * i, pOut + 3 * i);
+        if (i < Count) {
+            double in[36] = {1, 0, 0, 0, 1, 0, 0, 0, 1, 1, 0, 0, 0, 1, 0, 0, 0, 1,
+                             1, 0, 0, 0, 1, 0, 0, 0, 1, 1, 0, 0, 0, 1, 0, 0, 0, 1};   // Identities as padding
+            double out[12];
+            std::copy(pR + 9 * i, pR + 9 * Count, in);
+            detail::MatricesToEuler4Avx2(in, out);
+            std::copy(out, out + 3 * (Count - i), pOut + 3 * i);
+        }
+        return;
+    }
+#endif
+    for (std::size_t i = 0; i < Count; ++i) pRotDeg[i] = MatrixToEuler(pR + 9 * i);
+}
+
+} // namespace kernels
+
+#endif
@@ -0,0 +1,199 @@
+#ifndef BINARYPROTOCOL_HH
+#define BINARYPROTOCOL_HH
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include "ProtocolMessages.hh"
+
+/*!
+ * \file
+ * \brief Compact binary framing of the graphical server protocol.
+ *
+ * The connection starts with an 8-byte hello ("APMB", version, three
+ * zero bytes) followed by records. All integers and floats are little
+ * endian, floats are IEEE 754 single precision.
+ *
+ * | Record   | Layout                                                       | Size       |
+ * |----------|--------------------------------------------------------------|------------|
+ * | AddObj   | u8 1, u8 0, u16 name length, u32 id, f32 scale[3], f32 shift[3], f32 rot[3], u8 rgb[3], u8 0, name | 48 + name |
+ * | UpdateObj| u8 2, u8 fields, u16 0, u32 id, f32 shift[3], f32 rot[3]     | 32         |
+ * | Text     | u8 3, u8 0, u16 0, u32 length, text command                  | 8 + length |
+ * | DeltaObj | u8 4, u8 mask, u16 0, u32 id, f32 value for every bit set in mask | 8 + 4 * bits |
+ *
+ * AddObj binds the object name to an id used by the later UpdateObj
+ * and DeltaObj records. Text carries any other command in its text form.
+ * Bits 0-5 of the DeltaObj mask select, in this order, shift x, y, z
+ * and rotation x, y, z; only the selected values follow the header.
+ */
+namespace wire {
+
+constexpr char Magic[4] = {'A', 'P', 'M', 'B'};   //!< First bytes of a binary connection
+constexpr std::uint8_t Version = 1;               //!< Version sent in the hello
+constexpr std::size_t HelloSize = 8;              //!< Size of the hello
+
+/*!
+ * \brief Types of the records.
+ */
+enum RecordType : std::uint8_t {
+    AddObjRecord = 1,
+    UpdateObjRecord = 2,
+    TextRecord = 3,
+    DeltaObjRecord = 4
+};
+
+constexpr std::size_t AddObjSize = 48;      //!< Size of AddObj without the name
+constexpr std::size_t UpdateObjSize = 32;   //!< Size of UpdateObj
+constexpr std::size_t TextHeaderSize = 8;   //!< Size of Text without the command
+constexpr std::size_t DeltaHeaderSize = 8;  //!< Size of DeltaObj without the values
+constexpr int DeltaFieldCount = 6;          //!< Number of values selectable in a DeltaObj mask
+
+inline void PutU16(char* p, std::uint16_t v) {
+    p[0] = static_cast<char>(v & 0xff);
+    p[1] = static_cast<char>(v >> 8);
+}
+
+inline void PutU32(char* p, std::uint32_t v) {
+    for (int i = 0; i < 4; ++i) p[i] = static_cast<char>((v >> (8 * i)) & 0xff);
+}
+
+inline void PutF32(char* p, double v) {
+    const float f = static_cast<float>(v);
+    std::uint32_t bits;
+    std::memcpy(&bits, &f, sizeof(bits));
+    PutU32(p, bits);
+}
+
+inline std::uint16_t GetU16(const char* p) {
+    const unsigned char* u = reinterpret_cast<const unsigned char*>(p);
+    return static_cast<std::uint16_t>(u[0] | (u[1] << 8));
+}
+
+inline std::uint32_t GetU32(const char* p) {
+    const unsigned char* u = reinterpret_cast<const unsigned char*>(p);
+    return static_cast<std::uint32_t>(u[0]) | (static_cast<std::uint32_t>(u[1]) << 8)
+         | (static_cast<std::uint32_t>(u[2]) << 16) | (static_cast<std::uint32_t>(u[3]) << 24);
+}
+
+inline float GetF32(const char* p) {
+    const std::uint32_t bits = GetU32(p);
+    float f;
+    std::memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+} // namespace wire
+
+/*!
+ * \class BinaryEncoder
+ * \brief Builds binary records into a reusable buffer.
+ *
+ * Each method replaces the previous content of the buffer. The view
+ * returned by View() stays valid until the encoder is used again.
+ */
+class BinaryEncoder {
+private:
+    std::string Buffer;     //!< Encoded record, reused between records
+
+    /*!
+     * \brief Resizes the buffer to Size zero bytes and returns its data.
+     */
+    char* Reset(std::size_t Size) {
+        Buffer.assign(Size, '\0');
+        return &Buffer[0];
+    }
+
+public:
+    /*!
+     * \brief Encodes the hello starting a binary connection.
+     */
+    void Hello() {
+        char* p = Reset(wire::HelloSize);
+        std::memcpy(p, wire::Magic, sizeof(wire::Magic));
+        p[4] = static_cast<char>(wire::Version);
+    }
+
+    /*!
+     * \brief Encodes an AddObj record.
+     * \param id Id bound to the object.
+     * \param name Name of the object (at most 65535 bytes).
+     * \param def Initial state of the object.
+     */
+    void AddObj(std::uint32_t id, std::string_view name, const ObjDefinition& def) {
+        if (name.size() > 0xffff) name = name.substr(0, 0xffff);
+
+        char* p = Reset(wire::AddObjSize + name.size());
+        p[0] = static_cast<char>(wire::AddObjRecord);
+        wire::PutU16(p + 2, static_cast<std::uint16_t>(name.size()));
+        wire::PutU32(p + 4, id);
+        for (int i = 0; i < 3; ++i) {
+            wire::PutF32(p + 8 + 4 * i, def.Scale[i]);
+            wire::PutF32(p + 20 + 4 * i, def.Shift[i]);
+            wire::PutF32(p + 32 + 4 * i, def.RotXYZ_deg[i]);
+            p[44 + i] = static_cast<char>(def.RGB[i] & 0xff);
+        }
+        std::memcpy(p + wire::AddObjSize, name.data(), name.size());
+    }
+
+    /*!
+     * \brief Encodes an UpdateObj record.
+     * \param id Id of the object given in its AddObj record.
+     * \param upd Changed state of the object.
+     */
+    void UpdateObj(std::uint32_t id, const ObjUpdate& upd) {
+        char* p = Reset(wire::UpdateObjSize);
+        p[0] = static_cast<char>(wire::UpdateObjRecord);
+        p[1] = static_cast<char>(upd.Fields);
+        wire::PutU32(p + 4, id);
+        for (int i = 0; i < 3; ++i) {
+            wire::PutF32(p + 8 + 4 * i, upd.Shift[i]);
+            wire::PutF32(p + 20 + 4 * i, upd.RotXYZ_deg[i]);
+        }
+    }
+
+    /*!
+     * \brief Encodes a DeltaObj record.
+     * \param id Id of the object given in its AddObj record.
+     * \param mask Values to send (bits 0-5: shift x, y, z, rotation x, y, z).
+     * \param pValues All six values, only those selected by mask are encoded.
+     */
+    void DeltaObj(std::uint32_t id, std::uint8_t mask, const double* pValues) {
+        int count = 0;
+        for (int i = 0; i < wire::DeltaFieldCount; ++i) {
+            if (mask & (1u << i)) ++count;
+        }
+
+        char* p = Reset(wire::DeltaHeaderSize + 4 * count);
+        p[0] = static_cast<char>(wire::DeltaObjRecord);
+        p[1] = static_cast<char>(mask);
+        wire::PutU32(p + 4, id);
+        p += wire::DeltaHeaderSize;
+        for (int i = 0; i < wire::DeltaFieldCount; ++i) {
+            if (mask & (1u << i)) {
+                wire::PutF32(p, pValues[i]);
+                p += 4;
+            }
+        }
+    }
+
+    /*!
+     * \brief Encodes a Text record carrying a text command.
+     * \param command The command, including its trailing newline.
+     */
+    void Text(std::string_view command) {
+        char* p = Reset(wire::TextHeaderSize + command.size());
+        p[0] = static_cast<char>(wire::TextRecord);
+        wire::PutU32(p + 4, static_cast<std::uint32_t>(command.size()));
+        std::memcpy(p + wire::TextHeaderSize, command.data(), command.size());
+    }
+
+    /*!
+     * \brief Returns the encoded record.
+     */
+    std::string_view View() const {
+        return Buffer;
+    }
+};
+
+#endif
@@ -0,0 +1,155 @@
+#ifndef COMMANDARENA_HH
+#define COMMANDARENA_HH
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+#include "AbstractInterp4Command.hh"
+
+/*!
+ * \class CommandArena
+ * \brief Owner of all commands of a script, allocated from large blocks.
+ *
+ * Commands are constructed one after another in blocks of BlockSize
+ * bytes, so loading a script costs one allocation per block instead of
+ * one per line. Nothing is freed individually: Release() (or the
+ * destructor) destroys all commands, newest first, and frees the blocks.
+ *
+ * The destructors of the commands are code of the plugins, so the arena
+ * must be released before the plugin libraries are closed.
+ */
+class CommandArena {
+public:
+    static constexpr std::size_t BlockSize = 64 * 1024;   //!< Size of a regular block in bytes
+
+private:
+    /*!
+     * \brief Memory block released with the arena.
+     */
+    struct Block {
+        std::unique_ptr<unsigned char[]> pData;
+        std::size_t Size;
+    };
+
+    /*!
+     * \brief Command owned by the arena.
+     */
+    struct Owned {
+        AbstractInterp4Command* pCmd;
+        bool OnHeap;        //!< Created with new (see Adopt()), not in a block
+    };
+
+    std::vector<Block> Blocks;      //!< All blocks, the last one is being filled
+    std::size_t Used = 0;           //!< Bytes used in the last block
+    std::vector<Owned> Commands;    //!< Commands in creation order
+    std::size_t BytesAllocated = 0; //!< Total size of the blocks
+
+public:
+    CommandArena() = default;
+    CommandArena(const CommandArena&) = delete;
+    CommandArena& operator=(const CommandArena&) = delete;
+
+    ~CommandArena() { Release(); }
+
+    /*!
+     * \brief Returns uninitialized memory living until Release().
+     * \param Size Number of bytes.
+     * \param Alignment Required alignment (a power of two).
+     */
+    void* Allocate(std::size_t Size, std::size_t Alignment) {
+        if (!Blocks.empty()) {
+            unsigned char* pBase = Blocks.back().pData.get();
+            const std::uintptr_t start = reinterpret_cast<std::uintptr_t>(pBase) + Used;
+            const std::size_t padding = (Alignment - start % Alignment) % Alignment;
+            if (Used + padding + Size <= Blocks.back().Size) {
+                Used += padding + Size;
+                return pBase + (Used - Size);
+            }
+        }
+
+        // Objects larger than a block get a block of their own
+        const std::size_t blockSize = Size + Alignment > BlockSize ? Size + Alignment : BlockSize;
+        Blocks.push_back(Block{std::unique_ptr<unsigned char[]>(new unsigned char[blockSize]), blockSize});
+        BytesAllocated += blockSize;
+        Used = 0;
+        return Allocate(Size, Alignment);
+    }
+
+    /*!
+     * \brief Constructs a command in the arena.
+     * \tparam Cmd Concrete type of the command.
+     * \return The command, owned by the arena.
+     */
+    template<typename Cmd, typename... Args>
+    Cmd* Create(Args&&... args) {
+        if (Commands.size() == Commands.capacity()) {   // So that registering cannot throw after construction
+            Commands.reserve(2 * Commands.size() + 64);
+        }
+        Cmd* pCmd = new (Allocate(sizeof(Cmd), alignof(Cmd))) Cmd(std::forward<Args>(args)...);
+        Commands.push_back(Owned{pCmd, false});
+        return pCmd;
+    }
+
+    /*!
+     * \brief Takes over a command created with new, e.g. by a plugin without an arena factory.
+     */
+    void Adopt(AbstractInterp4Command* pCmd) {
+        if (pCmd) Commands.push_back(Owned{pCmd, true});
+    }
+
+    /*!
+     * \brief Takes over all commands and blocks of another arena.
+     *
+     * The taken commands are destroyed after the ones already owned,
+     * as if they had been created here. rOther is left empty.
+     */
+    void Splice(CommandArena& rOther) {
+        if (rOther.Blocks.empty() && rOther.Commands.empty()) return;
+
+        Commands.insert(Commands.end(), rOther.Commands.begin(), rOther.Commands.end());
+        if (!rOther.Blocks.empty()) {   // Allocation continues in the last taken block
+            Blocks.insert(Blocks.end(), std::make_move_iterator(rOther.Blocks.begin()),
+                          std::make_move_iterator(rOther.Blocks.end()));
+            Used = rOther.Used;
+        }
+        BytesAllocated += rOther.BytesAllocated;
+
+        rOther.Commands.clear();
+        rOther.Blocks.clear();
+        rOther.Used = 0;
+        rOther.BytesAllocated = 0;
+    }
+
+    /*!
+     * \brief Destroys all commands and frees the memory.
+     */
+    void Release() {
+        for (auto it = Commands.rbegin(); it != Commands.rend(); ++it) {
+            if (it->OnHeap) {
+                delete it->pCmd;
+            } else {
+                it->pCmd->~AbstractInterp4Command();
+            }
+        }
+        Commands.clear();
+        Blocks.clear();
+        Used = 0;
+        BytesAllocated = 0;
+    }
+
+    /*!
+     * \brief Number of owned commands.
+     */
+    std::size_t GetCommandCount() const { return Commands.size(); }
+
+    /*!
+     * \brief Total size of the allocated blocks in bytes.
+     */
+    std::size_t GetBytesAllocated() const { return BytesAllocated; }
+};
+
+#endif
@@ -9,6 +9,9 @@
 #include <sstream>
 #include "Vector3D.hh"
 #include "AbstractInterp4Command.hh"
+#include "Logger.hh"
+#include "Program.hh"
+#include "TokenCursor.hh"
 
 /*!
  * \class CubeConfig
@@ -39,8 +42,8 @@ private:
     std::list<std::string> Libs;                      //!< List of library paths
     std::map<std::string, std::string> LibCommands;   //!< Map of library paths to command names
     std::list<CubeConfig> Cubes;                      //!< List of cube configurations
-    std::list<std::list<AbstractInterp4Command*>> Commands; //!< List of commands, including parallel groups
-    std::map<std::string, double> Constants;
+    Program Commands;                                 //!< Compiled script (commands not owned)
+    TokenCursor::Constants Constants;                 //!< Constants defined with #define
 
 public:
     /*!
@@ -56,20 +59,21 @@ public:
     }
 
     /*!
-     * \brief Adds a standalone command to the configuration.
-     * \param command Pointer to the command to add.
+     * \brief Adds a command to the program, to the open parallel span if there is one.
+     *
+     * Constant time; the program is not printed here (see PrintCommands()).
+     * \param command Pointer to the command to add (owned by the interpreter's CommandArena).
+     * \param line Line of the script, 0 for generated commands.
      */
-    void AddStandaloneCommand(AbstractInterp4Command* command) {
-        Commands.push_back({command}); // Wrap the command in a single-element list
-        this->PrintCommands();
+    void AddStandaloneCommand(AbstractInterp4Command* command, std::uint32_t line = 0) {
+        Commands.Append(command, line);
     }
 
     /*!
-     * \brief Adds a list of parallel commands to the configuration.
-     * \param parallelCommands List of commands to add as a parallel group.
+     * \brief Provides the program for adding commands, e.g. parallel spans.
      */
-    void AddParallelCommands(const std::list<AbstractInterp4Command*>& parallelCommands) {
-        Commands.push_back(parallelCommands);
+    Program& GetProgram() {
+        return Commands;
     }
 
     /*!
@@ -111,84 +115,77 @@ public:
     }
 
     /*!
-     * \brief Retrieves the list of commands.
-     * \return A reference to the list of command groups.
+     * \brief Retrieves the compiled program.
+     * \return A reference to the program.
      */
-    const std::list<std::list<AbstractInterp4Command*>>& GetCommands() const {
+    const Program& GetCommands() const {
         return Commands;
     }
 
-    void AddConstant(const std::string& name, double value) {
-        Constants[name] = value;
+    void AddConstant(std::string_view name, double value) {
+        Constants.Define(name, value);
     }
 
-    const std::map<std::string, double>& GetConstants() const {
+    const TokenCursor::Constants& GetConstants() const {
         return Constants;
     }
 
     double GetConstantValue(const std::string& name) const {
-        auto it = Constants.find(name);
-        if (it != Constants.end()) {
-            return it->second;
+        if (const double* pValue = Constants.Find(name)) {
+            return *pValue;
         }
         throw std::runtime_error("Constant not found: " + name);
     }
 
-    std::string SubstituteConstants(const std::string& commandLine) const {
-        std::istringstream iss(commandLine);
-        std::ostringstream oss;
-        std::string token;
-
-        while (iss >> token) {
-            if (Constants.count(token)) {
-                oss << Constants.at(token) << " ";
-            } else {
-                oss << token << " ";
-            }
-        }
-        return oss.str();
-    }
-
     /*!
      * \brief Prints the loaded libraries, commands, and cube configurations.
      */
     void Print() const {
-        std::cout << "* Libraries and Commands: *\n";
+        if (!LOG_IS_ENABLED(APM_LOG_INFO)) return;
+
+        std::ostringstream dump;
+        dump << "* Libraries and Commands: *\n";
         for (const auto& lib : LibCommands) {
-            std::cout << "  Library: " << lib.first << ", Command: " << lib.second << "\n";
+            dump << "  Library: " << lib.first << ", Command: " << lib.second << "\n";
         }
 
-        std::cout << "\nCubes:\n";
+        dump << "\nCubes:\n";
         for (const auto& cube : Cubes) {
-            std::cout << "  Name: " << cube.Name << "\n"
-                      << "  Scale: " << cube.Scale << "\n"
-                      << "  Shift: " << cube.Shift << "\n"
-                      << "  Rotation: " << cube.Rotation << "\n"
-                      << "  Translation: " << cube.Translation << "\n"
-                      << "  RGB: " << cube.RGB << "\n";
+            dump << "  Name: " << cube.Name << "\n"
+                 << "  Scale: " << cube.Scale << "\n"
+                 << "  Shift: " << cube.Shift << "\n"
+                 << "  Rotation: " << cube.Rotation << "\n"
+                 << "  Translation: " << cube.Translation << "\n"
+                 << "  RGB: " << cube.RGB << "\n";
         }
 
-        std::cout << "* ------------------------------ *\n";
+        dump << "* ------------------------------ *";
+        LOG_INFO(dump.str());
     }
 
     /*!
      * \brief Prints all commands, including parallel groups.
+     *
+     * The listing is logged as one record, like Print(), so a long
+     * program cannot overflow the logger's queue.
      */
     void PrintCommands() const {
-        std::cout << "* All Commands: *\n";
-        for (const auto& commandGroup : Commands) {
-            if (commandGroup.size() > 1) {
-                std::cout << "Parallel Commands Start:\n";
-                for (const auto& command : commandGroup) {
-                    command->PrintCmd();
-                }
-                std::cout << "Parallel Commands End\n";
-            } else {
-                commandGroup.front()->PrintCmd();
+        if (!LOG_IS_ENABLED(APM_LOG_INFO)) return;
+
+        std::ostringstream dump;
+        dump << "* All Commands: *\n";
+        const auto& records = Commands.GetRecords();
+        for (const auto& span : Commands.GetSpans()) {
+            if (span.Parallel) dump << "Parallel Commands Start:\n";
+            for (std::uint32_t i = span.Begin; i < span.Begin + span.Count; ++i) {
+                records[i].pCmd->PrintCmd(dump);
+                dump << "\n";
             }
+            if (span.Parallel) dump << "Parallel Commands End\n";
         }
 
-        std::cout << "* ------------------------------ *\n";
+        dump << "* ------------------------------ *";
+        LOG_INFO(dump.str());
     }
 };
 
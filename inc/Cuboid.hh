@@ -2,6 +2,7 @@
 #define CUBOID_HH
 
 #include "AbstractMobileObj.hh"
+#include "ObjectStore.hh"
 #include "Vector3D.hh"
 #include <string>
 
@@ -9,42 +10,43 @@
  * \class Cuboid
  * \brief Represents a cuboid object in the scene.
  *
- * Implements the AbstractMobileObj interface.
+ * Implements the AbstractMobileObj interface as a thin view of one
+ * object kept in an ObjectStore; the cuboid itself holds no state.
  */
 class Cuboid : public AbstractMobileObj {
 private:
-    std::string name;   //!< Name of the cuboid
-    Vector3D position;  //!< Position in meters
-    Vector3D scale;     //!< Scale factors
-    Vector3D rotation;  //!< Rotation angles (roll, pitch, yaw) in degrees
-    Vector3D rgb;       //!< RGB color
+    ObjectStore* pStore;    //!< Storage holding the state of the cuboid
+    ObjectStore::ObjId Id;  //!< Index of the cuboid in the storage
 
 public:
-    Cuboid(const std::string& name, const Vector3D& position, const Vector3D& scale,
-           const Vector3D& rotation, const Vector3D& rgb)
-        : name(name), position(position), scale(scale), rotation(rotation), rgb(rgb) {}
+    Cuboid(ObjectStore& rStore, ObjectStore::ObjId Id) : pStore(&rStore), Id(Id) {}
 
     virtual ~Cuboid() override = default;
 
     // Getters
-    virtual double GetAng_Roll_deg() const override { return rotation[0]; }
-    virtual double GetAng_Pitch_deg() const override { return rotation[1]; }
-    virtual double GetAng_Yaw_deg() const override { return rotation[2]; }
+    virtual double GetAng_Roll_deg() const override { return pStore->Rotation(Id)[0]; }
+    virtual double GetAng_Pitch_deg() const override { return pStore->Rotation(Id)[1]; }
+    virtual double GetAng_Yaw_deg() const override { return pStore->Rotation(Id)[2]; }
 
-    virtual const Vector3D& GetPositoin_m() const override { return position; }
-    virtual const std::string& GetName() const override { return name; }
+    virtual const Vector3D& GetPositoin_m() const override { return pStore->Position(Id); }
+    virtual const std::string& GetName() const override { return pStore->Name(Id); }
 
     // Setters
-    virtual void SetAng_Roll_deg(double Ang_Roll_deg) override { rotation[0] = Ang_Roll_deg; }
-    virtual void SetAng_Pitch_deg(double Ang_Pitch_deg) override { rotation[1] = Ang_Pitch_deg; }
-    virtual void SetAng_Yaw_deg(double Ang_Yaw_deg) override { rotation[2] = Ang_Yaw_deg; }
+    virtual void SetAng_Roll_deg(double Ang_Roll_deg) override { pStore->Rotation(Id)[0] = Ang_Roll_deg; pStore->MarkDirty(Id); }
+    virtual void SetAng_Pitch_deg(double Ang_Pitch_deg) override { pStore->Rotation(Id)[1] = Ang_Pitch_deg; pStore->MarkDirty(Id); }
+    virtual void SetAng_Yaw_deg(double Ang_Yaw_deg) override { pStore->Rotation(Id)[2] = Ang_Yaw_deg; pStore->MarkDirty(Id); }
 
-    virtual void SetPosition_m(const Vector3D& rPos) override { position = rPos; }
-    virtual void SetName(const char* sName) override { name = sName; }
+    virtual void SetPosition_m(const Vector3D& rPos) override { pStore->Position(Id) = rPos; pStore->MarkDirty(Id); }
+    virtual void SetName(const char* sName) override { pStore->Name(Id) = sName; }
 
     // Additional getters for scale and color
-    const Vector3D& GetScale() const { return scale; }
-    const Vector3D& GetColor() const { return rgb; }
+    const Vector3D& GetScale() const { return pStore->Scale(Id); }
+    const Vector3D& GetColor() const { return pStore->Color(Id); }
+
+    /*!
+     * \brief Index of the cuboid in its ObjectStore.
+     */
+    ObjectStore::ObjId GetId() const { return Id; }
 };
 
 #endif
@@ -5,23 +5,36 @@
 #include <memory>
 #include <dlfcn.h>
 #include "AbstractInterp4Command.hh"
+#include "CommandArena.hh"
 
 /*!
  * \class LibInterface
  * \brief Manages a single library (plugin) and its associated command.
  *
  * This class loads a dynamic library, retrieves a function pointer to create
- * the associated command, and manages the command's instance.
+ * the associated command, and manages the command's instance. The factory
+ * pointer is resolved once, when the library is loaded.
  */
 class LibInterface {
 public:
+    /*!
+     * \brief Factory function exported by a plugin as CreateCmd.
+     */
+    using CmdFactory = AbstractInterp4Command* (*)();
+
+    /*!
+     * \brief Factory function optionally exported by a plugin as CreateCmdIn,
+     *        constructing the command in a CommandArena.
+     */
+    using ArenaCmdFactory = AbstractInterp4Command* (*)(CommandArena&);
+
     /*!
      * \brief Constructs a LibInterface with the library and command names.
      * \param libName Name of the dynamic library file to load (e.g., "libInterp4Move.so").
      * \param cmdName Name of the command associated with this library.
      */
     LibInterface(const std::string& libName, const std::string& cmdName)
-        : libraryName(libName), commandName(cmdName), libraryHandle(nullptr), commandInstance(nullptr) {}
+        : libraryName(libName), commandName(cmdName), libraryHandle(nullptr), createCmdFunc(nullptr), createCmdInFunc(nullptr), commandInstance(nullptr) {}
 
     /*!
      * \brief Loads the dynamic library and creates the command instance.
@@ -35,15 +48,19 @@ public:
             return false;
         }
 
-        auto createCmdFunc = reinterpret_cast<AbstractInterp4Command* (*)()>(dlsym(libraryHandle, "CreateCmd"));
-        
+        createCmdFunc = reinterpret_cast<CmdFactory>(dlsym(libraryHandle, "CreateCmd"));
+
         if (!createCmdFunc) {
             std::cerr << "Function CreateCmd not found in " << libraryName << "\n";
             std::cerr << "dlerror: " << dlerror() << "\n";
             dlclose(libraryHandle);
+            libraryHandle = nullptr;
             return false;
         }
 
+        // Optional; commands of plugins without it are created with new and adopted by the arena
+        createCmdInFunc = reinterpret_cast<ArenaCmdFactory>(dlsym(libraryHandle, "CreateCmdIn"));
+
         commandInstance = std::unique_ptr<AbstractInterp4Command>(createCmdFunc());
         return true;
     }
@@ -56,6 +73,8 @@ public:
             dlclose(libraryHandle);  // Close the library handle
             std::cout << "LibInterface destructor\n";
             libraryHandle = nullptr;
+            createCmdFunc = nullptr;
+            createCmdInFunc = nullptr;
         }
     }
 
@@ -71,14 +90,32 @@ public:
      */
     AbstractInterp4Command* getCommandInstance() const { return commandInstance.get(); }
 
+    /*!
+     * \brief Provides the factory of the command, resolved by loadLibrary().
+     * \return The factory, nullptr if the library is not loaded.
+     */
+    CmdFactory getFactory() const { return createCmdFunc; }
+
+    /*!
+     * \brief Creates a new instance of the command through the cached factory.
+     * \return The new command (owned by the caller), nullptr if the library is not loaded.
+     */
     AbstractInterp4Command* CreateCmd() const {
-        auto createCmdFunc = reinterpret_cast<AbstractInterp4Command* (*)()>(dlsym(libraryHandle, "CreateCmd"));
-        if (!createCmdFunc) {
-            std::cerr << "Function CreateCmd not found in " << libraryName << "\n";
-            std::cerr << "dlerror: " << dlerror() << "\n";
-            return nullptr;
+        return createCmdFunc ? createCmdFunc() : nullptr;
+    }
+
+    /*!
+     * \brief Creates a new instance of the command owned by an arena.
+     * \param rArena Arena of the script the command belongs to.
+     * \return The new command, nullptr if the library is not loaded.
+     */
+    AbstractInterp4Command* CreateCmd(CommandArena& rArena) const {
+        if (createCmdInFunc) {
+            return createCmdInFunc(rArena);
         }
-        return createCmdFunc();
+        AbstractInterp4Command* pCmd = CreateCmd();
+        rArena.Adopt(pCmd);
+        return pCmd;
     }
 
     /*!
@@ -93,6 +130,8 @@ private:
     std::string libraryName;  ///< Name of the dynamic library file
     std::string commandName;  ///< Name of the command associated with this library
     void* libraryHandle;      ///< Handle to the loaded dynamic library
+    CmdFactory createCmdFunc; ///< CreateCmd of the library, resolved once by loadLibrary()
+    ArenaCmdFactory createCmdInFunc; ///< CreateCmdIn of the library, nullptr if not exported
     std::unique_ptr<AbstractInterp4Command> commandInstance;  ///< Instance of the command from the library
 };
 
@@ -0,0 +1,264 @@
+#ifndef LOGGER_HH
+#define LOGGER_HH
+
+/*!
+ * \file
+ * \brief Leveled logger with an asynchronous sink.
+ *
+ * Messages are written with the LOG_TRACE ... LOG_ERROR macros, e.g.
+ * \code
+ *   LOG_DEBUG("Added object: " << name);
+ * \endcode
+ * Levels below APM_LOG_LEVEL (set at compile time, e.g.
+ * -DAPM_LOG_LEVEL=APM_LOG_DEBUG) expand to nothing, so their arguments
+ * are not even evaluated. Enabled messages are formatted into a
+ * thread-local buffer, pushed into a lock-free queue and written
+ * by a background thread.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include "MpscRing.hh"
+
+#define APM_LOG_TRACE  0
+#define APM_LOG_DEBUG  1
+#define APM_LOG_INFO   2
+#define APM_LOG_WARN   3
+#define APM_LOG_ERROR  4
+#define APM_LOG_OFF    5
+
+#ifndef APM_LOG_LEVEL
+#define APM_LOG_LEVEL  APM_LOG_INFO
+#endif
+
+/*!
+ * \class Logger
+ * \brief Process-wide logger writing from a background thread.
+ *
+ * Records of level APM_LOG_WARN and above go to stderr, the others to stdout.
+ * When the queue is full, records below APM_LOG_WARN are dropped rather than
+ * stalling the caller.
+ */
+class Logger {
+private:
+    /*!
+     * \brief Single formatted message.
+     */
+    struct Record {
+        int Level = APM_LOG_INFO;   //!< Level of the message
+        std::string Text;           //!< Formatted message, without the trailing newline
+    };
+
+    MpscRing<Record> Queue;                 //!< Records waiting for the sink
+    std::atomic<int> Threshold;             //!< Runtime threshold (never below APM_LOG_LEVEL)
+    std::atomic<std::uint64_t> Dropped;     //!< Records lost because the queue was full
+    std::atomic<std::size_t> Written;       //!< Number of queue positions already written
+    std::atomic<bool> Stopping;             //!< Set when the logger is being destroyed
+    std::mutex WakeMutex;                   //!< Used only with WakeCond
+    std::condition_variable WakeCond;       //!< Wakes the sink before its polling period elapses
+    std::thread Sink;                       //!< Background writer
+
+    Logger() : Queue(8192), Threshold(APM_LOG_LEVEL), Dropped(0), Written(0), Stopping(false) {
+        Sink = std::thread(&Logger::SinkLoop, this);
+    }
+
+    /*!
+     * \brief Returns the formatting buffer of the calling thread.
+     */
+    static std::ostringstream& ThreadBuffer() {
+        thread_local std::ostringstream buffer;
+        return buffer;
+    }
+
+    /*!
+     * \brief Main loop of the sink thread.
+     */
+    void SinkLoop() {
+        std::string out, err;
+        Record record;
+        std::size_t position;
+
+        for (;;) {
+            std::size_t taken = 0;
+            while (Queue.TryPop(record, &position)) {
+                std::string& target = record.Level >= APM_LOG_WARN ? err : out;
+                target += record.Text;
+                target += '\n';
+                ++taken;
+            }
+
+            if (!out.empty()) {
+                std::fwrite(out.data(), 1, out.size(), stdout);
+                std::fflush(stdout);
+                out.clear();
+            }
+            if (!err.empty()) {
+                std::fwrite(err.data(), 1, err.size(), stderr);
+                err.clear();
+            }
+            if (taken) {
+                Written.store(position + 1, std::memory_order_release);
+                continue;
+            }
+
+            if (Stopping) return;
+
+            std::unique_lock<std::mutex> lock(WakeMutex);
+            WakeCond.wait_for(lock, std::chrono::milliseconds(10));
+        }
+    }
+
+public:
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+
+    /*!
+     * \brief Writes the remaining records and stops the sink.
+     */
+    ~Logger() {
+        Stopping = true;
+        WakeCond.notify_one();
+        if (Sink.joinable()) {
+            Sink.join();
+        }
+    }
+
+    /*!
+     * \brief Returns the process-wide logger.
+     */
+    static Logger& Instance() {
+        static Logger instance;
+        return instance;
+    }
+
+    /*!
+     * \brief Checks whether messages of the given level are written.
+     * \param level One of APM_LOG_TRACE ... APM_LOG_ERROR.
+     */
+    bool IsEnabled(int level) const {
+        return level >= Threshold.load(std::memory_order_relaxed);
+    }
+
+    /*!
+     * \brief Changes the runtime threshold.
+     *
+     * Levels removed at compile time cannot be enabled again.
+     * \param level One of APM_LOG_TRACE ... APM_LOG_OFF.
+     */
+    void SetLevel(int level) {
+        Threshold = level < APM_LOG_LEVEL ? APM_LOG_LEVEL : level;
+    }
+
+    /*!
+     * \brief Starts a new message in the buffer of the calling thread.
+     * \return Stream into which the message is formatted.
+     */
+    std::ostream& Begin() {
+        std::ostringstream& buffer = ThreadBuffer();
+        buffer.str(std::string());
+        buffer.clear();
+        return buffer;
+    }
+
+    /*!
+     * \brief Queues the message formatted since Begin().
+     * \param level Level of the message.
+     */
+    void Commit(int level) {
+        Record record;
+        record.Level = level;
+        record.Text = ThreadBuffer().str();
+
+        if (!Queue.TryPush(record)) {
+            if (level < APM_LOG_WARN) {
+                ++Dropped;
+                return;
+            }
+            do {
+                WakeCond.notify_one();
+                std::this_thread::yield();
+            } while (!Queue.TryPush(record));
+        }
+
+        if (level >= APM_LOG_WARN) {
+            WakeCond.notify_one();
+        }
+    }
+
+    /*!
+     * \brief Waits until all messages queued so far have been written.
+     *
+     * Useful before printing directly to std::cout.
+     */
+    void Flush() {
+        const std::size_t target = Queue.NextPosition();
+        while (Written.load(std::memory_order_acquire) < target) {
+            WakeCond.notify_one();
+            std::this_thread::yield();
+        }
+    }
+
+    /*!
+     * \brief Number of records dropped because the queue was full.
+     */
+    std::uint64_t GetDropped() const {
+        return Dropped;
+    }
+};
+
+/*!
+ * \brief Formats and queues a message if its level is enabled at runtime.
+ */
+#define APM_LOG_WRITE(level, expr)                          \
+    do {                                                    \
+        Logger& apmLogger_ = Logger::Instance();            \
+        if (apmLogger_.IsEnabled(level)) {                  \
+            apmLogger_.Begin() << expr;                     \
+            apmLogger_.Commit(level);                       \
+        }                                                   \
+    } while (0)
+
+/*!
+ * \brief True if messages of the given level are compiled in and enabled.
+ */
+#define LOG_IS_ENABLED(level) \
+    ((level) >= APM_LOG_LEVEL && Logger::Instance().IsEnabled(level))
+
+#if APM_LOG_LEVEL <= APM_LOG_TRACE
+#define LOG_TRACE(expr) APM_LOG_WRITE(APM_LOG_TRACE, expr)
+#else
+#define LOG_TRACE(expr) do {} while (0)
+#endif
+
+#if APM_LOG_LEVEL <= APM_LOG_DEBUG
+#define LOG_DEBUG(expr) APM_LOG_WRITE(APM_LOG_DEBUG, expr)
+#else
+#define LOG_DEBUG(expr) do {} while (0)
+#endif
+
+#if APM_LOG_LEVEL <= APM_LOG_INFO
+#define LOG_INFO(expr) APM_LOG_WRITE(APM_LOG_INFO, expr)
+#else
+#define LOG_INFO(expr) do {} while (0)
+#endif
+
+#if APM_LOG_LEVEL <= APM_LOG_WARN
+#define LOG_WARN(expr) APM_LOG_WRITE(APM_LOG_WARN, expr)
+#else
+#define LOG_WARN(expr) do {} while (0)
+#endif
+
+#if APM_LOG_LEVEL <= APM_LOG_ERROR
+#define LOG_ERROR(expr) APM_LOG_WRITE(APM_LOG_ERROR, expr)
+#else
+#define LOG_ERROR(expr) do {} while (0)
+#endif
+
+#endif
@@ -0,0 +1,131 @@
+#ifndef MPSCRING_HH
+#define MPSCRING_HH
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+/*!
+ * \class MpscRing
+ * \brief Bounded lock-free queue for many producers and a single consumer.
+ *
+ * Every cell carries a sequence number telling whether it is free for
+ * the producer of a given position or ready for the consumer
+ * (D. Vyukov's bounded queue). Producers claim positions with
+ * a compare-and-swap, so pushing never takes a mutex. The capacity is
+ * rounded up to a power of two.
+ *
+ * \tparam Type Type of the queued elements.
+ */
+template<typename Type>
+class MpscRing {
+private:
+    /*!
+     * \brief Single slot of the ring.
+     */
+    struct Cell {
+        std::atomic<std::size_t> Sequence;  //!< Position for which the cell is ready
+        Type Data;                          //!< Stored element
+    };
+
+    std::unique_ptr<Cell[]> Cells;          //!< Storage of the ring
+    std::size_t Mask;                       //!< Capacity - 1
+
+    alignas(64) std::atomic<std::size_t> EnqueuePos;  //!< Next position claimed by producers
+    alignas(64) std::atomic<std::size_t> DequeuePos;  //!< Next position read by the consumer
+
+public:
+    /*!
+     * \brief Allocates the ring.
+     * \param Capacity Requested number of cells (rounded up to a power of two).
+     */
+    explicit MpscRing(std::size_t Capacity) : EnqueuePos(0), DequeuePos(0) {
+        std::size_t size = 2;
+        while (size < Capacity) size <<= 1;
+
+        Cells.reset(new Cell[size]);
+        Mask = size - 1;
+        for (std::size_t i = 0; i < size; ++i) {
+            Cells[i].Sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpscRing(const MpscRing&) = delete;
+    MpscRing& operator=(const MpscRing&) = delete;
+
+    /*!
+     * \brief Tries to append an element. Safe to call from many threads.
+     * \param rValue Element moved into the ring when there is room for it.
+     * \return True if the element was queued, false if the ring is full.
+     */
+    bool TryPush(Type& rValue) {
+        std::size_t pos = EnqueuePos.load(std::memory_order_relaxed);
+
+        for (;;) {
+            Cell& cell = Cells[pos & Mask];
+            const std::size_t seq = cell.Sequence.load(std::memory_order_acquire);
+            const std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+
+            if (diff == 0) {
+                if (EnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.Data = std::move(rValue);
+                    cell.Sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;   // The consumer has not released this cell yet
+            } else {
+                pos = EnqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /*!
+     * \brief Takes the oldest element. May be called by the consumer thread only.
+     * \param rValue Receives the element.
+     * \param pPos If not null, receives the position under which the element was queued.
+     * \return True if an element was taken, false if the ring is empty.
+     */
+    bool TryPop(Type& rValue, std::size_t* pPos = nullptr) {
+        const std::size_t pos = DequeuePos.load(std::memory_order_relaxed);
+        Cell& cell = Cells[pos & Mask];
+        const std::size_t seq = cell.Sequence.load(std::memory_order_acquire);
+
+        if (seq != pos + 1) {
+            return false;
+        }
+
+        rValue = std::move(cell.Data);
+        if (pPos) *pPos = pos;
+        cell.Sequence.store(pos + Mask + 1, std::memory_order_release);
+        DequeuePos.store(pos + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /*!
+     * \brief Approximate number of queued elements.
+     */
+    std::size_t SizeApprox() const {
+        const std::size_t enq = EnqueuePos.load(std::memory_order_relaxed);
+        const std::size_t deq = DequeuePos.load(std::memory_order_relaxed);
+        return enq > deq ? enq - deq : 0;
+    }
+
+    /*!
+     * \brief Position which will be claimed by the next successful push.
+     *
+     * Positions grow monotonically, so they order the queued elements
+     * against anything stamped with this value.
+     */
+    std::size_t NextPosition() const {
+        return EnqueuePos.load(std::memory_order_acquire);
+    }
+
+    /*!
+     * \brief Number of cells of the ring.
+     */
+    std::size_t Capacity() const { return Mask + 1; }
+};
+
+#endif
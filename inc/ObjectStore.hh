@@ -0,0 +1,202 @@
+#ifndef OBJECTSTORE_HH
+#define OBJECTSTORE_HH
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <string>
+#include <vector>
+#include "Vector3D.hh"
+
+/*!
+ * \class AlignedAllocator
+ * \brief Allocator returning memory aligned to a given boundary.
+ *
+ * \tparam Type Type of the allocated elements.
+ * \tparam Alignment Required alignment in bytes (e.g. a cache line).
+ */
+template<typename Type, std::size_t Alignment>
+class AlignedAllocator {
+public:
+    using value_type = Type;
+
+    template<typename Other>
+    struct rebind { using other = AlignedAllocator<Other, Alignment>; };
+
+    AlignedAllocator() = default;
+
+    template<typename Other>
+    AlignedAllocator(const AlignedAllocator<Other, Alignment>&) {}
+
+    Type* allocate(std::size_t Count) {
+        return static_cast<Type*>(::operator new(Count * sizeof(Type), std::align_val_t(Alignment)));
+    }
+
+    void deallocate(Type* pData, std::size_t) {
+        ::operator delete(pData, std::align_val_t(Alignment));
+    }
+
+    template<typename Other>
+    bool operator==(const AlignedAllocator<Other, Alignment>&) const { return true; }
+
+    template<typename Other>
+    bool operator!=(const AlignedAllocator<Other, Alignment>&) const { return false; }
+};
+
+/*!
+ * \class ObjectStore
+ * \brief Contiguous structure-of-arrays storage of the scene objects.
+ *
+ * Every property is kept in its own cache-line aligned array indexed by
+ * the object id, so code updating one property of many objects (e.g.
+ * all positions in a tick) streams through memory instead of following
+ * one heap pointer per object. Cuboid is a thin view of one id.
+ *
+ * Code modifying positions or rotations directly has to call
+ * MarkDirty(), so that SceneGraph recomputes the world transforms.
+ * The marked ids are also collected in a list (see TakeDirtyIds()), so
+ * a frame costs in proportion to the changed objects, not to all of them.
+ *
+ * Adding an object may move the arrays, which invalidates references
+ * and data pointers obtained earlier. Objects are therefore added while
+ * loading, or after Reserve() for the expected number of objects.
+ */
+class ObjectStore {
+public:
+    using ObjId = std::uint32_t;    //!< Index of an object in the arrays
+
+    /*!
+     * \brief Array of one property of all objects.
+     */
+    using PropertyArray = std::vector<Vector3D, AlignedAllocator<Vector3D, 64>>;
+
+private:
+    PropertyArray Positions;        //!< Positions in meters
+    PropertyArray Rotations;        //!< Roll, pitch and yaw in degrees
+    PropertyArray Scales;           //!< Scale factors
+    PropertyArray Colors;           //!< RGB colors
+    std::vector<std::string> Names; //!< Names (cold data, kept apart from the hot arrays)
+
+    /*!
+     * \brief Flag telling that the local transform of an object changed.
+     *
+     * Copyable only so that the array can grow while loading.
+     */
+    struct DirtyFlag {
+        std::atomic<bool> Value;
+        DirtyFlag() : Value(false) {}
+        DirtyFlag(const DirtyFlag& rOther) : Value(rOther.Value.load()) {}
+    };
+    std::vector<DirtyFlag> Dirty;   //!< Set by MarkDirty(), cleared by ClearDirty()
+    std::vector<ObjId> DirtyIds;    //!< Ids whose flag was set since the last TakeDirtyIds()
+    std::mutex DirtyIdsMutex;       //!< Guards DirtyIds
+
+public:
+    /*!
+     * \brief Reserves room for the given number of objects.
+     */
+    void Reserve(std::size_t Count) {
+        Positions.reserve(Count);
+        Rotations.reserve(Count);
+        Scales.reserve(Count);
+        Colors.reserve(Count);
+        Names.reserve(Count);
+        Dirty.reserve(Count);
+    }
+
+    /*!
+     * \brief Appends an object.
+     * \return Id of the new object.
+     */
+    ObjId Add(const std::string& Name, const Vector3D& Position, const Vector3D& Scale,
+              const Vector3D& Rotation, const Vector3D& Color) {
+        Positions.push_back(Position);
+        Rotations.push_back(Rotation);
+        Scales.push_back(Scale);
+        Colors.push_back(Color);
+        Names.push_back(Name);
+        Dirty.emplace_back();
+        return static_cast<ObjId>(Names.size() - 1);
+    }
+
+    /*!
+     * \brief Number of stored objects.
+     */
+    std::size_t Size() const { return Names.size(); }
+
+    Vector3D& Position(ObjId Id) { return Positions[Id]; }
+    const Vector3D& Position(ObjId Id) const { return Positions[Id]; }
+
+    Vector3D& Rotation(ObjId Id) { return Rotations[Id]; }
+    const Vector3D& Rotation(ObjId Id) const { return Rotations[Id]; }
+
+    Vector3D& Scale(ObjId Id) { return Scales[Id]; }
+    const Vector3D& Scale(ObjId Id) const { return Scales[Id]; }
+
+    Vector3D& Color(ObjId Id) { return Colors[Id]; }
+    const Vector3D& Color(ObjId Id) const { return Colors[Id]; }
+
+    std::string& Name(ObjId Id) { return Names[Id]; }
+    const std::string& Name(ObjId Id) const { return Names[Id]; }
+
+    /*!
+     * \brief Marks the local transform (position or rotation) of an object as changed.
+     *
+     * Must be called by everything that modifies Position() or Rotation(),
+     * under the lock guarding the object. Only the call setting the flag takes the lock of the list, so an
+     * object changed many times in a frame is listed once.
+     */
+    void MarkDirty(ObjId Id) {
+        if (Dirty[Id].Value.load(std::memory_order_relaxed) || Dirty[Id].Value.exchange(true, std::memory_order_acq_rel)) {
+            return;     // Already listed
+        }
+        std::lock_guard<std::mutex> lock(DirtyIdsMutex);
+        DirtyIds.push_back(Id);
+    }
+
+    /*!
+     * \brief Takes the ids marked by MarkDirty() since the previous call.
+     *
+     * The flags stay set until ClearDirty(), so further changes made
+     * meanwhile do not list the ids again.
+     * \param rIds Receives the ids, in no particular order; its previous
+     *             contents are dropped and its capacity is reused.
+     */
+    void TakeDirtyIds(std::vector<ObjId>& rIds) {
+        rIds.clear();
+        std::lock_guard<std::mutex> lock(DirtyIdsMutex);
+        rIds.swap(DirtyIds);
+    }
+
+    /*!
+     * \brief Clears the flag of an id taken by TakeDirtyIds().
+     *
+     * Must be called under the lock guarding the object, before its state
+     * is read, so that a change made afterwards lists the id again.
+     */
+    void ClearDirty(ObjId Id) { Dirty[Id].Value.store(false, std::memory_order_release); }
+
+    /*!
+     * \brief Positions of all objects, for bulk processing (Size() elements).
+     */
+    Vector3D* PositionData() { return Positions.data(); }
+
+    /*!
+     * \brief Rotations of all objects, for bulk processing (Size() elements).
+     */
+    Vector3D* RotationData() { return Rotations.data(); }
+
+    /*!
+     * \brief Scales of all objects, for bulk processing (Size() elements).
+     */
+    Vector3D* ScaleData() { return Scales.data(); }
+
+    /*!
+     * \brief Colors of all objects, for bulk processing (Size() elements).
+     */
+    Vector3D* ColorData() { return Colors.data(); }
+};
+
+#endif
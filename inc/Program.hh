@@ -0,0 +1,99 @@
+#ifndef PROGRAM_HH
+#define PROGRAM_HH
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "AbstractInterp4Command.hh"
+
+/*!
+ * \class Program
+ * \brief Compiled script: one array of command records and one array of spans.
+ *
+ * Commands are stored in script order in a single vector. A span is a
+ * range of that vector whose commands run either one after another
+ * (consecutive standalone commands share one sequential span) or all
+ * at once (a ParalelStart/ParalelEnd block). Executing the program is a
+ * linear walk over both vectors.
+ */
+class Program {
+public:
+    /*!
+     * \brief Command of the script.
+     */
+    struct Record {
+        AbstractInterp4Command* pCmd;   //!< The command (owned by the interpreter's CommandArena)
+        std::uint32_t Line;             //!< Line of the script, 0 for generated commands
+    };
+
+    /*!
+     * \brief Range of records executed together.
+     */
+    struct Span {
+        std::uint32_t Begin;            //!< Index of the first record
+        std::uint32_t Count;            //!< Number of records
+        bool Parallel;                  //!< Records run concurrently rather than one by one
+    };
+
+private:
+    std::vector<Record> Records;        //!< All commands in script order
+    std::vector<Span> Spans;            //!< Consecutive spans covering Records
+    bool InParallel = false;            //!< Between BeginParallel() and EndParallel()
+
+public:
+    /*!
+     * \brief Appends a command to the current span.
+     *
+     * Outside a parallel block the command extends the last sequential
+     * span or opens a new one.
+     */
+    void Append(AbstractInterp4Command* pCmd, std::uint32_t Line = 0) {
+        if (!InParallel && (Spans.empty() || Spans.back().Parallel)) {
+            Spans.push_back(Span{static_cast<std::uint32_t>(Records.size()), 0, false});
+        }
+        Records.push_back(Record{pCmd, Line});
+        ++Spans.back().Count;
+    }
+
+    /*!
+     * \brief Opens a span whose commands run concurrently.
+     * \return False if a parallel span is already open.
+     */
+    bool BeginParallel() {
+        if (InParallel) return false;
+        Spans.push_back(Span{static_cast<std::uint32_t>(Records.size()), 0, true});
+        InParallel = true;
+        return true;
+    }
+
+    /*!
+     * \brief Closes the parallel span; an empty one is dropped.
+     * \return False if no parallel span is open.
+     */
+    bool EndParallel() {
+        if (!InParallel) return false;
+        if (Spans.back().Count == 0) Spans.pop_back();
+        InParallel = false;
+        return true;
+    }
+
+    /*!
+     * \brief Tells whether a parallel span is open.
+     */
+    bool IsInParallel() const { return InParallel; }
+
+    /*!
+     * \brief Reserves room for the given number of commands.
+     */
+    void Reserve(std::size_t Count) { Records.reserve(Count); }
+
+    const std::vector<Record>& GetRecords() const { return Records; }
+    const std::vector<Span>& GetSpans() const { return Spans; }
+
+    /*!
+     * \brief Number of commands.
+     */
+    std::size_t Size() const { return Records.size(); }
+};
+
+#endif
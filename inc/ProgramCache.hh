@@ -0,0 +1,120 @@
+#ifndef PROGRAMCACHE_HH
+#define PROGRAMCACHE_HH
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+/*!
+ * \file
+ * \brief Binary cache of a loaded program.
+ *
+ * The cache lets a run skip parsing config.xml and the command script
+ * when neither changed since the run which wrote it. It is a machine-local
+ * file: values are stored in the native byte order and the header
+ * rejects a file written with another one.
+ *
+ * | Part     | Layout                                                         |
+ * |----------|----------------------------------------------------------------|
+ * | Header   | "APMPROG" 0, u32 version, u32 byte order mark, u64 key         |
+ * | Libs     | u32 count, per library: string name, u64 file size, i64 mtime  |
+ * | Cubes    | u32 count, per cube: string name, f64 scale, shift, rotation, translation, rgb (3 each) |
+ * | Commands | u32 count, per command: u32 library index, u32 line, string parameters |
+ * | Spans    | u32 count, per span: u32 begin, u32 count, u32 parallel        |
+ *
+ * A string is a u32 length followed by the bytes. The key is a hash of
+ * the cache version and the contents of config.xml and of the script;
+ * the size and modification time of every plugin are checked as well,
+ * since the parameters are encoded by the plugins (see
+ * AbstractInterp4Command::SaveParams()).
+ */
+namespace progcache {
+
+constexpr char Magic[8] = {'A', 'P', 'M', 'P', 'R', 'O', 'G', '\0'};   //!< First bytes of a cache
+constexpr std::uint32_t Version = 1;                                    //!< Format of the cache
+constexpr std::uint32_t ByteOrderMark = 0x01020304;                     //!< Reads differently in another byte order
+
+/*!
+ * \brief Appends a number in the native byte order.
+ */
+template<typename T>
+inline void Put(std::string& rOut, T Value) {
+    static_assert(std::is_arithmetic<T>::value, "only numbers are stored directly");
+    char bytes[sizeof(T)];
+    std::memcpy(bytes, &Value, sizeof(T));
+    rOut.append(bytes, sizeof(T));
+}
+
+/*!
+ * \brief Appends a string preceded by its length.
+ */
+inline void PutString(std::string& rOut, std::string_view Value) {
+    Put(rOut, static_cast<std::uint32_t>(Value.size()));
+    rOut.append(Value.data(), Value.size());
+}
+
+/*!
+ * \brief Reads a number from the front of the data and consumes it.
+ * \return False if the data is too short.
+ */
+template<typename T>
+inline bool Get(std::string_view& rIn, T& rValue) {
+    static_assert(std::is_arithmetic<T>::value, "only numbers are stored directly");
+    if (rIn.size() < sizeof(T)) return false;
+    std::memcpy(&rValue, rIn.data(), sizeof(T));
+    rIn.remove_prefix(sizeof(T));
+    return true;
+}
+
+/*!
+ * \brief Reads a string from the front of the data and consumes it.
+ * \param rValue View into the data.
+ * \return False if the data is too short.
+ */
+inline bool GetString(std::string_view& rIn, std::string_view& rValue) {
+    std::uint32_t length;
+    if (!Get(rIn, length) || rIn.size() < length) return false;
+    rValue = rIn.substr(0, length);
+    rIn.remove_prefix(length);
+    return true;
+}
+
+/*!
+ * \brief Reads a string from the front of the data and consumes it.
+ */
+inline bool GetString(std::string_view& rIn, std::string& rValue) {
+    std::string_view view;
+    if (!GetString(rIn, view)) return false;
+    rValue.assign(view.data(), view.size());
+    return true;
+}
+
+/*!
+ * \brief 64-bit FNV-1a hash of the inputs of a cache.
+ */
+class KeyHasher {
+private:
+    std::uint64_t Hash = 1469598103934665603ull;
+
+public:
+    /*!
+     * \brief Adds bytes to the hash, preceded by their length so that inputs cannot run together.
+     */
+    void Add(std::string_view Bytes) {
+        const std::uint64_t length = Bytes.size();
+        for (int i = 0; i < 8; ++i) Mix(static_cast<unsigned char>(length >> (8 * i)));
+        for (char c : Bytes) Mix(static_cast<unsigned char>(c));
+    }
+
+    void Mix(unsigned char Byte) {
+        Hash = (Hash ^ Byte) * 1099511628211ull;
+    }
+
+    std::uint64_t Get() const { return Hash; }
+};
+
+}
+
+#endif
@@ -1,19 +1,47 @@
 #ifndef PROGRAMINTERPRETER_HH
 #define PROGRAMINTERPRETER_HH
 
+#include <chrono>
+#include <cstdint>
+#include <map>
 #include <string>
+#include <string_view>
+#include <vector>
 #include "AbstractScene.hh"
 #include "xmlinterp.hh"
 #include "Set4LibInterfaces.hh"
 #include "Cuboid.hh"
 #include "Scene.hh"
 #include "Sender.hh"
+#include "WorkerPool.hh"
+#include "AnimationScheduler.hh"
 #include <xercesc/sax2/SAX2XMLReader.hpp>
 #include <xercesc/util/XMLString.hpp>
 
 class ProgramInterpreter {
 public:
-    ProgramInterpreter() = default;
+    /*!
+     * \brief Statistics of loading the command file.
+     */
+    struct LoadStats {
+        using Duration = std::chrono::duration<double, std::milli>;
+
+        std::size_t Lines = 0;                              //!< Lines read, including comments
+        std::size_t Bytes = 0;                              //!< Size of the script
+        std::size_t Chunks = 0;                             //!< Parts of the script parsed concurrently
+        std::map<std::string, std::size_t> CommandsPerType; //!< Number of commands by name
+        Duration ScanTime{0};                               //!< Pre-scan of constants and blocks
+        Duration ParseTime{0};                              //!< Reading parameters, summed over the threads
+        Duration BindTime{0};                               //!< Resolving object names, summed over the threads
+        Duration TotalTime{0};                              //!< Whole LoadCommands()
+    };
+
+    /*!
+     * \brief Creates the interpreter.
+     * \param[in] WorkerCount - number of threads executing commands,
+     *                          0 selects the number of hardware threads.
+     */
+    explicit ProgramInterpreter(unsigned int WorkerCount = 0) : pool(WorkerCount), animations(scene, sender) {}
     ~ProgramInterpreter() = default;
 
     /*!
@@ -29,7 +57,119 @@ public:
      */
     void Run();
 
+    /*!
+     * \brief Makes Run() send messages through the asynchronous Sender mode.
+     * \param[in] policy - what to do when the outbound queue is full.
+     */
+    void EnableAsyncSending(BackpressurePolicy policy) {
+        asyncSending = true;
+        asyncPolicy = policy;
+    }
+
+    /*!
+     * \brief Selects the encoding used by Run() on the server connection.
+     * \param[in] format - text commands or the binary records.
+     */
+    void SetWireFormat(WireFormat format) {
+        wireFormat = format;
+    }
+
+    /*!
+     * \brief Sets the precision of the object states sent to the server.
+     * \param[in] shiftStep - step of the shift, 0 disables rounding,
+     * \param[in] angleStep - step of the angles in degrees, 0 disables rounding.
+     */
+    void SetQuantization(double shiftStep, double angleStep) {
+        shiftQuantum = shiftStep;
+        angleQuantum = angleStep;
+    }
+
+    /*!
+     * \brief Makes Init() keep the loaded program in a binary cache file.
+     *
+     * When the cache matches config.xml, the script and the plugins, Init()
+     * loads the program from it instead of parsing them; otherwise it
+     * parses them and rewrites the cache.
+     * \param[in] path - the cache file, empty disables the cache.
+     */
+    void SetProgramCache(const std::string& path) {
+        cachePath = path;
+    }
+
+    /*!
+     * \brief Makes Init() print the whole loaded program.
+     */
+    void SetVerbose(bool enabled) {
+        verbose = enabled;
+    }
+
+    /*!
+     * \brief Statistics of the last LoadCommands().
+     */
+    const LoadStats& GetLoadStats() const {
+        return loadStats;
+    }
+
 private:
+    /*!
+     * \brief Line of the script found by the pre-scan.
+     */
+    struct ScriptEntry {
+        enum class Kind { Command, ParallelStart, ParallelEnd, Define };
+
+        Kind Type;                              //!< What the line holds
+        std::uint32_t Line;                     //!< Number of the line, from 1
+        std::string_view Text;                  //!< The line, a view into the mapped script
+        AbstractInterp4Command* pCmd = nullptr; //!< Command created from the line
+    };
+
+    /*!
+     * \brief Error found while loading the script.
+     */
+    struct ScriptError {
+        std::size_t Line = 0;                   //!< Line of the error, 0 if there is none
+        std::string Message;                    //!< Description without the line number
+    };
+
+    /*!
+     * \brief Commands created from a consecutive part of the script by one thread.
+     */
+    struct ScriptChunk {
+        CommandArena Arena;                     //!< Owns the commands until they are merged
+        LoadStats Stats;                        //!< Statistics of this part
+        ScriptError Error;                      //!< First error of this part
+    };
+
+    /*!
+     * \brief Outcome of loading the program cache.
+     */
+    enum class CacheResult {
+        Missed,     //!< No usable cache, nothing was changed
+        Loaded,     //!< The program was loaded from the cache
+        Failed      //!< The cache was valid, but loading the program from it failed half way
+    };
+
+    /*!
+     * \brief Computes the key of the program cache.
+     * \param[in] configPath - Path to the XML configuration file.
+     * \param[in] commandsPath - Path to the commands file.
+     * \param[out] key - hash of the cache version and of both files.
+     * \return False if one of the files cannot be read.
+     */
+    static bool ComputeCacheKey(const std::string& configPath, const std::string& commandsPath, std::uint64_t& key);
+
+    /*!
+     * \brief Loads the libraries, objects and commands from the program cache.
+     * \param[in] key - key of the current configuration and script.
+     */
+    CacheResult LoadProgramCache(std::uint64_t key);
+
+    /*!
+     * \brief Writes the loaded libraries, objects and script commands to the program cache.
+     * \param[in] key - key of the current configuration and script.
+     */
+    void SaveProgramCache(std::uint64_t key) const;
+
     /*!
      * \brief Parses the configuration XML file.
      * \param[in] configPath - Path to the XML configuration file.
@@ -39,11 +179,36 @@ private:
 
     /*!
      * \brief Loads commands from the command file.
+     *
+     * The script is scanned once for constants and parallel blocks, then
+     * its command lines are parsed in chunks on the worker pool and merged
+     * into the program in script order.
      * \param[in] commandsPath - Path to the commands file.
      * \return True if commands are loaded successfully.
      */
     bool LoadCommands(const std::string& commandsPath);
 
+    /*!
+     * \brief Pre-scan of the script: defines constants, checks the blocks and lists the command lines.
+     * \param[in] script - text of the script,
+     * \param[out] entries - command and block lines in script order,
+     * \param[out] error - first error; the scan stops at it.
+     * \return True if a constant is defined after the first command, so that
+     *         the commands must be parsed in order (see ParseChunk()).
+     */
+    bool ScanScript(std::string_view script, std::vector<ScriptEntry>& entries, ScriptError& error);
+
+    /*!
+     * \brief Creates the commands of a part of the script.
+     *
+     * Stops at the first error. Safe to run concurrently for disjoint
+     * parts without #define entries.
+     * \param[in,out] pFirst - first entry of the part,
+     * \param[in] count - number of entries,
+     * \param[in,out] chunk - receives the commands, statistics and error.
+     */
+    void ParseChunk(ScriptEntry* pFirst, std::size_t count, ScriptChunk& chunk);
+
     /*!
      * \brief Loads commands from the command file.
      * \param[in] commandsPath - Path to the commands file.
@@ -53,6 +218,20 @@ private:
 
     bool LoadObjects();
 
+    /*!
+     * \brief Prints the statistics of loading the command file.
+     */
+    void PrintLoadStats() const;
+
+    /*!
+     * \brief Executes commands together and waits until all of them finish.
+     * \param[in] pFirst - first record of the group in the program,
+     * \param[in] count - number of commands, all started at once,
+     * \param[in] groupIndex - number of the group, logged with its time (LOG_INFO for
+     *            parallel groups, LOG_DEBUG for single commands).
+     */
+    void RunGroup(const Program::Record* pFirst, std::size_t count, std::size_t groupIndex);
+
     /*!
      * \brief Initializes the XML parser.
      * \return True if the XML parser initializes successfully.
@@ -61,8 +240,20 @@ private:
 
     Scene scene; //!< Instance of the Scene class.
     Sender sender;
+    bool asyncSending = false;    //!< Use the asynchronous Sender mode
+    BackpressurePolicy asyncPolicy = BackpressurePolicy::Coalesce; //!< Policy of the asynchronous mode
+    WireFormat wireFormat = WireFormat::Text;  //!< Encoding of the server connection
+    double shiftQuantum = 0;      //!< Step of the shifts sent to the server
+    double angleQuantum = 0;      //!< Step of the angles sent to the server
+    bool verbose = false;         //!< Print the loaded program
+    std::string cachePath;        //!< Program cache file, empty if disabled
+    std::size_t scriptBegin = 0;  //!< Index of the first record loaded from the script
+    LoadStats loadStats;          //!< Statistics of LoadCommands()
     Configuration config;   //!< Configuration object.
     Set4LibInterfaces plugins;    //!< Keep Lis
+    CommandArena commandArena;    //!< Owns the commands of the script, destroyed before the plugins are closed
+    WorkerPool pool;              //!< Persistent threads executing command groups
+    AnimationScheduler animations; //!< Frame clock stepping animated commands
 };
 
 #endif
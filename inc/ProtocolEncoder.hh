@@ -0,0 +1,168 @@
+#ifndef PROTOCOLENCODER_HH
+#define PROTOCOLENCODER_HH
+
+#include <charconv>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include "ProtocolMessages.hh"
+
+/*!
+ * \class ProtocolEncoder
+ * \brief Formats text commands of the graphical server protocol into a reusable buffer.
+ *
+ * Numbers are written with std::to_chars, which neither allocates nor
+ * depends on the locale. The buffer keeps its capacity between
+ * messages, so once it has grown to the size of the longest message
+ * encoding does not touch the heap at all. A typical use is
+ * \code
+ *   enc.BeginUpdateObj(name);
+ *   enc.Triple("RotXYZ_deg", roll, pitch, yaw);
+ *   enc.End();
+ *   Send(enc.View());
+ * \endcode
+ * The view stays valid only until the encoder is used again.
+ */
+class ProtocolEncoder {
+private:
+    std::string Buffer;     //!< Encoded message, reused between messages
+
+    /*!
+     * \brief Writes the text of a number into [first, last).
+     */
+    template<typename Number>
+    static std::to_chars_result FormatNumber(char* first, char* last, Number value) {
+        if constexpr (std::is_floating_point_v<Number>) {
+            // Same text as the default formatting of std::ostream
+            return std::to_chars(first, last, value, std::chars_format::general, 6);
+        } else {
+            return std::to_chars(first, last, value);
+        }
+    }
+
+    /*!
+     * \brief Appends a number.
+     * \param value Number to append.
+     */
+    template<typename Number>
+    void AppendNumber(Number value) {
+        constexpr std::size_t maxLength = 32;
+        const std::size_t used = Buffer.size();
+        Buffer.resize(used + maxLength);
+
+        char* first = &Buffer[used];
+        const std::to_chars_result result = FormatNumber(first, first + maxLength, value);
+        Buffer.resize(result.ptr - Buffer.data());
+    }
+
+    /*!
+     * \brief Length of the parameter " Key=(x,y,z)" without encoding it.
+     */
+    template<typename Number>
+    static std::size_t TripleLength(std::string_view key, Number x, Number y, Number z) {
+        char digits[32];
+        std::size_t length = key.size() + 6;   // " Key=(" "," "," ")"
+        for (Number value : {x, y, z}) {
+            length += FormatNumber(digits, digits + sizeof(digits), value).ptr - digits;
+        }
+        return length;
+    }
+
+public:
+    /*!
+     * \brief Starts an AddObj command, discarding the previous message.
+     * \param name Name of the object.
+     */
+    void BeginAddObj(std::string_view name) {
+        Buffer.clear();
+        Buffer += "AddObj Name=";
+        Buffer += name;
+    }
+
+    /*!
+     * \brief Starts an UpdateObj command, discarding the previous message.
+     * \param name Name of the object.
+     */
+    void BeginUpdateObj(std::string_view name) {
+        Buffer.clear();
+        Buffer += "UpdateObj Name=";
+        Buffer += name;
+    }
+
+    /*!
+     * \brief Appends a parameter of the form " Key=(x,y,z)".
+     * \param key Name of the parameter.
+     */
+    template<typename Number>
+    void Triple(std::string_view key, Number x, Number y, Number z) {
+        Buffer += ' ';
+        Buffer += key;
+        Buffer += "=(";
+        AppendNumber(x);
+        Buffer += ',';
+        AppendNumber(y);
+        Buffer += ',';
+        AppendNumber(z);
+        Buffer += ')';
+    }
+
+    /*!
+     * \brief Terminates the command.
+     */
+    void End() {
+        Buffer += '\n';
+    }
+
+    /*!
+     * \brief Encodes a complete AddObj command.
+     * \param name Name of the object.
+     * \param def Initial state of the object.
+     */
+    void AddObj(std::string_view name, const ObjDefinition& def) {
+        BeginAddObj(name);
+        Triple("Scale", def.Scale[0], def.Scale[1], def.Scale[2]);
+        Triple("Shift", def.Shift[0], def.Shift[1], def.Shift[2]);
+        Triple("RotXYZ_deg", def.RotXYZ_deg[0], def.RotXYZ_deg[1], def.RotXYZ_deg[2]);
+        Triple("RGB", def.RGB[0], def.RGB[1], def.RGB[2]);
+        End();
+    }
+
+    /*!
+     * \brief Encodes a complete UpdateObj command with the fields selected in upd.
+     * \param name Name of the object.
+     * \param upd Changed state of the object.
+     */
+    void UpdateObj(std::string_view name, const ObjUpdate& upd) {
+        BeginUpdateObj(name);
+        if (upd.Fields & ObjUpdate::HasShift) {
+            Triple("Shift", upd.Shift[0], upd.Shift[1], upd.Shift[2]);
+        }
+        if (upd.Fields & ObjUpdate::HasRotation) {
+            Triple("RotXYZ_deg", upd.RotXYZ_deg[0], upd.RotXYZ_deg[1], upd.RotXYZ_deg[2]);
+        }
+        End();
+    }
+
+    /*!
+     * \brief Length of the message UpdateObj() would encode, without encoding it.
+     */
+    static std::size_t UpdateObjLength(std::string_view name, const ObjUpdate& upd) {
+        std::size_t length = 15 + name.size() + 1;   // "UpdateObj Name=" name ... '\n'
+        if (upd.Fields & ObjUpdate::HasShift) {
+            length += TripleLength("Shift", upd.Shift[0], upd.Shift[1], upd.Shift[2]);
+        }
+        if (upd.Fields & ObjUpdate::HasRotation) {
+            length += TripleLength("RotXYZ_deg", upd.RotXYZ_deg[0], upd.RotXYZ_deg[1], upd.RotXYZ_deg[2]);
+        }
+        return length;
+    }
+
+    /*!
+     * \brief Returns the encoded message.
+     */
+    std::string_view View() const {
+        return Buffer;
+    }
+};
+
+#endif
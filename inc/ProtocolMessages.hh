@@ -0,0 +1,48 @@
+#ifndef PROTOCOLMESSAGES_HH
+#define PROTOCOLMESSAGES_HH
+
+#include <cstdint>
+
+/*!
+ * \file
+ * \brief Structured messages sent to the graphical server.
+ *
+ * Commands pass object states to the communication channel in these
+ * structures, the channel decides how they are encoded on the wire.
+ */
+
+/*!
+ * \brief Encoding used on the connection with the graphical server.
+ */
+enum class WireFormat {
+    Text,     //!< Text commands understood by the original server
+    Binary    //!< Compact records described in BinaryProtocol.hh
+};
+
+/*!
+ * \brief Initial state of an object, sent with AddObj.
+ */
+struct ObjDefinition {
+    double Scale[3] = {1, 1, 1};        //!< Scale factors
+    double Shift[3] = {0, 0, 0};        //!< Position
+    double RotXYZ_deg[3] = {0, 0, 0};   //!< Roll, pitch and yaw in degrees
+    int RGB[3] = {255, 255, 255};       //!< Color
+};
+
+/*!
+ * \brief Changed state of an object, sent with UpdateObj.
+ *
+ * Only the fields selected in Fields are transmitted.
+ */
+struct ObjUpdate {
+    enum Field : std::uint8_t {
+        HasShift = 1,       //!< Shift is set
+        HasRotation = 2     //!< RotXYZ_deg is set
+    };
+
+    std::uint8_t Fields = 0;            //!< Combination of Field flags
+    double Shift[3] = {0, 0, 0};        //!< Position
+    double RotXYZ_deg[3] = {0, 0, 0};   //!< Roll, pitch and yaw in degrees
+};
+
+#endif
@@ -1,36 +1,155 @@
 #ifndef SCENE_HH
 #define SCENE_HH
 
+#include "AbstractComChannel.hh"
 #include "AbstractScene.hh"
+#include "Cuboid.hh"
+#include "ObjectStore.hh"
+#include "Logger.hh"
+#include "SceneGraph.hh"
+#include <memory>
 #include <unordered_map>
 #include <string>
 #include <mutex>
+#include <shared_mutex>
+#include <vector>
 
 /*!
  * \class Scene
  * \brief Implements AbstractScene and manages mobile objects.
+ *
+ * The name index is guarded by a reader-writer lock, so lookups made
+ * by parallel commands do not exclude each other. The state of every
+ * object is guarded by its own mutex (see GetObjMutex()), so animations
+ * of unrelated objects never wait for each other.
+ *
+ * Cuboids created with AddCuboid() keep their state in the scene's
+ * ObjectStore, in contiguous per-property arrays, and form a SceneGraph
+ * following their dotted names (see BuildHierarchy()).
  */
 class Scene : public AbstractScene {
 private:
-    std::unordered_map<std::string, AbstractMobileObj*> objects; //!< Stores mobile objects
-    std::mutex sceneMutex; //!< Mutex for synchronizing access
+    /*!
+     * \brief Object stored in the scene together with its lock.
+     */
+    struct Entry {
+        AbstractMobileObj* pObj = nullptr;  //!< The object (owned by the scene)
+        std::mutex Mutex;                   //!< Guards the state of the object
+    };
+
+    std::unordered_map<std::string, std::unique_ptr<Entry>> objects;           //!< Name -> object
+    std::unordered_map<const AbstractMobileObj*, Entry*> entries;              //!< Object -> its entry
+    mutable std::shared_mutex indexMutex; //!< Guards both indexes (not the objects)
+    ObjectStore store;      //!< State of the cuboids created by AddCuboid() (outlives their views)
+    std::vector<Entry*> storeEntries;   //!< Store id -> entry of the cuboid
+    SceneGraph graph;       //!< Hierarchy and world transforms of the cuboids
 
 public:
     ~Scene() override {
         for (auto& obj : objects) {
-            delete obj.second; // Clean up memory
+            delete obj.second->pObj; // Clean up memory
         }
     }
 
     /*!
      * \brief Add a new mobile object to the scene.
+     *
+     * An object previously added under the same name is replaced and
+     * deleted, which is safe only while no command uses it (e.g. during loading).
+     * A cuboid of the store is never replaced, since its slot would stay
+     * in the store and in the hierarchy; the new object is deleted instead.
      * \param pMobObj Pointer to the mobile object to add.
      */
     void AddMobileObj(AbstractMobileObj* pMobObj) override {
         if (pMobObj) {
-            std::lock_guard<std::mutex> lock(sceneMutex); // Lock the scene while modifying
-            objects[pMobObj->GetName()] = pMobObj;
+            std::unique_lock<std::shared_mutex> lock(indexMutex); // Exclusive while modifying the index
+            std::unique_ptr<Entry>& entry = objects[pMobObj->GetName()];
+            if (!entry) {
+                entry.reset(new Entry);
+            }
+
+            if (dynamic_cast<Cuboid*>(entry->pObj)) {
+                LOG_ERROR("Object " << pMobObj->GetName() << " already exists, the new one is ignored.");
+                delete pMobObj;
+                return;
+            }
+            if (entry->pObj) {
+                entries.erase(entry->pObj);
+                delete entry->pObj;
+            }
+            entry->pObj = pMobObj;
+            entries[pMobObj] = entry.get();
+        }
+    }
+
+    /*!
+     * \brief Creates a cuboid stored in the scene's ObjectStore and adds it to the scene.
+     *
+     * Must not be called while commands are running, since the store
+     * may have to move its arrays.
+     * \return The view of the new cuboid, nullptr if an object with
+     *         this name already exists (the scene is left unchanged).
+     */
+    Cuboid* AddCuboid(const std::string& name, const Vector3D& position, const Vector3D& scale,
+                      const Vector3D& rotation, const Vector3D& rgb) {
+        std::unique_lock<std::shared_mutex> lock(indexMutex);
+        std::unique_ptr<Entry>& entry = objects[name];
+        if (entry) {
+            return nullptr;
         }
+        entry.reset(new Entry);
+
+        Cuboid* pCuboid = new Cuboid(store, store.Add(name, position, scale, rotation, rgb));
+        entry->pObj = pCuboid;
+        entries[pCuboid] = entry.get();
+        storeEntries.push_back(entry.get());
+        return pCuboid;
+    }
+
+    /*!
+     * \brief Provides the contiguous storage of the cuboids, e.g. for bulk updates.
+     */
+    ObjectStore& GetStore() {
+        return store;
+    }
+
+    /*!
+     * \brief Builds the hierarchy of the cuboids from their dotted names.
+     *
+     * Called once after all objects are loaded.
+     */
+    void BuildHierarchy() {
+        graph.Build(store);
+    }
+
+    /*!
+     * \brief Provides the hierarchy of the cuboids.
+     */
+    const SceneGraph& GetGraph() const {
+        return graph;
+    }
+
+    /*!
+     * \brief Sends the world transform of every cuboid whose world transform changed.
+     *
+     * The server places every object on its own, so a cuboid follows its
+     * parent only through these updates: moving a cuboid sends it and its
+     * moved descendants (see SceneGraph::Update()).
+     * The channel must be locked; it also serializes the calls.
+     */
+    void PublishChanges(AbstractComChannel& rComChann) override {
+        ObjUpdate update;
+        update.Fields = ObjUpdate::HasShift | ObjUpdate::HasRotation;
+
+        graph.Update(store,
+            [this](ObjectStore::ObjId id) { return std::lock_guard<std::mutex>(storeEntries[id]->Mutex); },
+            [&](ObjectStore::ObjId id, const Vector3D& position, const Vector3D& rotation) {
+                for (int i = 0; i < 3; ++i) {
+                    update.Shift[i] = position[i];
+                    update.RotXYZ_deg[i] = rotation[i];
+                }
+                rComChann.SendObjUpdate(store.Name(id), update);
+            });
     }
 
     /*!
@@ -39,19 +158,20 @@ public:
      * \return Pointer to the object if found, nullptr otherwise.
      */
     AbstractMobileObj* FindMobileObj(const char* sName) override {
-        std::lock_guard<std::mutex> lock(sceneMutex); // Lock the scene while accessing
+        std::shared_lock<std::shared_mutex> lock(indexMutex); // Readers do not exclude each other
         auto it = objects.find(sName);
-        return (it != objects.end()) ? it->second : nullptr;
+        return (it != objects.end()) ? it->second->pObj : nullptr;
     }
 
     /*!
-     * \brief Provides access to the scene's mutex for external synchronization.
-     * \return Reference to the scene's mutex.
+     * \brief Provides the mutex guarding the state of one object.
+     * \param pMobObj Object of this scene, as returned by FindMobileObj().
+     * \return Reference to the object's mutex, valid as long as the object is in the scene.
      */
-    std::mutex& GetMutex() override {
-        return sceneMutex;
+    std::mutex& GetObjMutex(const AbstractMobileObj* pMobObj) override {
+        std::shared_lock<std::shared_mutex> lock(indexMutex);
+        return entries.at(pMobObj)->Mutex;
     }
 };
 
 #endif
-
@@ -0,0 +1,300 @@
+#ifndef SCENEGRAPH_HH
+#define SCENEGRAPH_HH
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "BatchKernels.hh"
+#include "Logger.hh"
+#include "ObjectStore.hh"
+
+/*!
+ * \class SceneGraph
+ * \brief Parent/child hierarchy of the objects of an ObjectStore.
+ *
+ * The hierarchy follows the dotted names of the objects: the parent of
+ * "Podstawa.Ramie1.Ramie2" is "Podstawa.Ramie1". For every object the
+ * graph caches its world transform, i.e. its local transform (position
+ * and rotation kept in the store) composed with the world transform of
+ * its parent.
+ *
+ * Update() visits only the subtrees of the objects marked dirty in the
+ * store (see ObjectStore::TakeDirtyIds()). The objects are kept in
+ * depth-first order, so every subtree is one contiguous range of it.
+ * When many objects changed, one sweep over all of them is cheaper and
+ * is used instead (see SweepRatio).
+ * Within a subtree only the dirty objects and the children of objects
+ * whose world transform changed are recomputed. The local transforms are
+ * cached, and the rotations of all dirty objects are converted to
+ * matrices in one call of kernels::EulerToMatrices(). The world rotations
+ * of the moved objects are converted back to angles in one call of
+ * kernels::MatricesToEuler().
+ */
+class SceneGraph {
+public:
+    using ObjId = ObjectStore::ObjId;
+
+    static constexpr ObjId NoParent = ~ObjId(0);    //!< Parent of the root objects
+
+    /*!
+     * \brief Update() sweeps all of Order once at least 1/SweepRatio of the objects changed.
+     *
+     * Sorting the changed objects to walk only their subtrees costs more
+     * than the sweep, which checks two flags per unchanged object.
+     */
+    static constexpr std::size_t SweepRatio = 16;
+
+    /*!
+     * \brief Rigid transform: rotation matrix (row-major) and translation.
+     */
+    struct Transform {
+        double R[9] = {1, 0, 0, 0, 1, 0, 0, 0, 1};
+        double T[3] = {0, 0, 0};
+
+        bool operator==(const Transform& rOther) const {
+            for (int i = 0; i < 9; ++i) if (R[i] != rOther.R[i]) return false;
+            for (int i = 0; i < 3; ++i) if (T[i] != rOther.T[i]) return false;
+            return true;
+        }
+    };
+
+private:
+    std::vector<ObjId> Parents;         //!< Parent of every object (by id)
+    std::vector<ObjId> Order;           //!< Ids in depth-first order, parents before children
+    std::vector<std::uint32_t> OrderPos;    //!< Index of every object in Order (by id)
+    std::vector<std::uint32_t> SubtreeEnd;  //!< End of the object's subtree in Order (by id)
+    std::vector<Transform, AlignedAllocator<Transform, 64>> World;  //!< World transforms (by id)
+    std::vector<Transform, AlignedAllocator<Transform, 64>> Local;  //!< Local transforms as of the last Update() (by id)
+    std::vector<std::uint8_t> Moved;    //!< World transform changed in the current Update() (by id)
+    std::vector<Vector3D> LocalRotations;       //!< Rotations of the local transforms (by id)
+    std::vector<std::uint8_t> Changed;  //!< Local transform changed since the previous Update() (by id)
+    std::vector<ObjId> ChangedIds;      //!< Ids taken from the store, reused between updates
+    std::vector<Vector3D> ChangedRotations;     //!< Rotations of ChangedIds, input of the Euler kernel
+    std::vector<double> ChangedMatrices;        //!< 9 doubles per entry of ChangedIds
+    std::vector<ObjId> MovedIds;        //!< Ids with Moved set in the current Update(), in Order
+    std::vector<double> MovedMatrices;  //!< World rotations of the moved objects which have a parent
+    std::vector<Vector3D> MovedRotations;       //!< The same as roll, pitch and yaw
+    std::size_t RootCount = 0;          //!< Number of objects without a parent
+
+    /*!
+     * \brief Composes the parent's world transform with a local transform.
+     * \param pParent World transform of the parent, nullptr for a root.
+     * \param rLocal Local transform (see kernels::EulerToMatrix() for its rotation).
+     */
+    static Transform Compose(const Transform* pParent, const Transform& rLocal) {
+        if (!pParent) return rLocal;
+
+        Transform result;
+        const double* local = rLocal.R;
+        for (int r = 0; r < 3; ++r) {
+            for (int c = 0; c < 3; ++c) {
+                result.R[3 * r + c] = pParent->R[3 * r] * local[c]
+                                    + pParent->R[3 * r + 1] * local[3 + c]
+                                    + pParent->R[3 * r + 2] * local[6 + c];
+            }
+            result.T[r] = pParent->R[3 * r] * rLocal.T[0] + pParent->R[3 * r + 1] * rLocal.T[1]
+                        + pParent->R[3 * r + 2] * rLocal.T[2] + pParent->T[r];
+        }
+        return result;
+    }
+
+    /*!
+     * \brief Recomputes the changed objects of a range of Order and the children of moved objects.
+     *
+     * The parent of every object in the range, except the first one, must
+     * be in the range too, i.e. the range is a subtree or all of Order.
+     * The moved objects are appended to MovedIds.
+     */
+    void Walk(std::uint32_t Begin, std::uint32_t End) {
+        for (std::uint32_t i = Begin; i < End; ++i) {
+            const ObjId id = Order[i];
+            const ObjId parent = Parents[id];
+            if (!Changed[id] && (parent == NoParent || !Moved[parent])) {
+                Moved[id] = 0;
+                continue;
+            }
+            Changed[id] = 0;
+
+            const Transform world = Compose(parent == NoParent ? nullptr : &World[parent], Local[id]);
+            Moved[id] = !(world == World[id]);
+            if (Moved[id]) {
+                World[id] = world;
+                MovedIds.push_back(id);
+            }
+        }
+    }
+
+    /*!
+     * \brief Reports the objects in MovedIds, with the world rotations converted in one kernel call.
+     *
+     * A root reports its own angles, which need no conversion.
+     */
+    template<typename MovedFn>
+    void ReportMoved(MovedFn& OnMoved) {
+        MovedMatrices.clear();
+        for (ObjId id : MovedIds) {
+            if (Parents[id] != NoParent) MovedMatrices.insert(MovedMatrices.end(), World[id].R, World[id].R + 9);
+        }
+        MovedRotations.resize(MovedMatrices.size() / 9);
+        kernels::MatricesToEuler(MovedMatrices.data(), MovedRotations.data(), MovedRotations.size());
+
+        std::size_t converted = 0;
+        for (ObjId id : MovedIds) {
+            const Transform& world = World[id];
+            const Vector3D position(world.T[0], world.T[1], world.T[2]);
+            OnMoved(id, position, Parents[id] == NoParent ? LocalRotations[id] : MovedRotations[converted++]);
+        }
+    }
+
+public:
+    /*!
+     * \brief Builds the hierarchy of all objects of the store and computes their world transforms.
+     *
+     * An object whose parent name is not in the store becomes a root.
+     * Must be called after loading, before the objects are modified by commands.
+     */
+    void Build(ObjectStore& rStore) {
+        const std::size_t count = rStore.Size();
+        std::unordered_map<std::string, ObjId> ids;
+        ids.reserve(count);
+        for (ObjId id = 0; id < count; ++id) {
+            ids[rStore.Name(id)] = id;
+        }
+
+        Parents.assign(count, NoParent);
+        std::vector<std::vector<ObjId>> children(count);
+        std::vector<ObjId> roots;
+        for (ObjId id = 0; id < count; ++id) {
+            const std::string& name = rStore.Name(id);
+            const std::size_t dot = name.rfind('.');
+            if (dot != std::string::npos) {
+                auto parent = ids.find(name.substr(0, dot));
+                if (parent != ids.end()) {
+                    Parents[id] = parent->second;
+                    children[parent->second].push_back(id);
+                    continue;
+                }
+                LOG_WARN("Parent of " << name << " not found, treating it as a root");
+            }
+            roots.push_back(id);
+        }
+        RootCount = roots.size();
+
+        Order.clear();
+        Order.reserve(count);
+        std::vector<ObjId> stack(roots.rbegin(), roots.rend());
+        while (!stack.empty()) {
+            const ObjId id = stack.back();
+            stack.pop_back();
+            Order.push_back(id);
+            stack.insert(stack.end(), children[id].rbegin(), children[id].rend());
+        }
+
+        OrderPos.assign(count, 0);
+        SubtreeEnd.assign(count, 0);
+        for (std::uint32_t i = 0; i < count; ++i) {
+            OrderPos[Order[i]] = i;
+            SubtreeEnd[Order[i]] = i + 1;
+        }
+        for (std::size_t i = count; i-- > 0; ) {   // Children before their parents
+            const ObjId parent = Parents[Order[i]];
+            if (parent != NoParent) SubtreeEnd[parent] = std::max(SubtreeEnd[parent], SubtreeEnd[Order[i]]);
+        }
+
+        std::vector<double> matrices(9 * count);
+        kernels::EulerToMatrices(rStore.RotationData(), matrices.data(), count);
+
+        Local.assign(count, Transform());
+        World.assign(count, Transform());
+        LocalRotations.assign(rStore.RotationData(), rStore.RotationData() + count);
+        Moved.assign(count, 0);
+        Changed.assign(count, 0);
+        rStore.TakeDirtyIds(ChangedIds);    // Changes made while loading are included below
+        for (ObjId id : ChangedIds) rStore.ClearDirty(id);
+        for (ObjId id = 0; id < count; ++id) {
+            std::copy(&matrices[9 * id], &matrices[9 * id] + 9, Local[id].R);
+            for (int i = 0; i < 3; ++i) Local[id].T[i] = rStore.Position(id)[i];
+        }
+        for (ObjId id : Order) {
+            World[id] = Compose(Parents[id] == NoParent ? nullptr : &World[Parents[id]], Local[id]);
+        }
+    }
+
+    /*!
+     * \brief Recomputes the world transforms affected by the changes since the last call.
+     *
+     * Calls must not overlap. Every dirty object is read under the
+     * lock returned by Lock(id).
+     * \param rStore The store the graph was built for.
+     * \param Lock Callable returning a lock guarding the state of an object.
+     * \param OnMoved Callable invoked as OnMoved(id, position, rotation) with the
+     *                world position and the world roll, pitch and yaw (degrees)
+     *                of every object whose world transform changed, parents
+     *                before their children. This includes the descendants of
+     *                a modified object, whose local state did not change.
+     */
+    template<typename LockFn, typename MovedFn>
+    void Update(ObjectStore& rStore, LockFn&& Lock, MovedFn&& OnMoved) {
+        // Read the changed objects, then convert all their rotations in one kernel call
+        rStore.TakeDirtyIds(ChangedIds);
+        if (ChangedIds.empty()) return;
+
+        ChangedRotations.resize(ChangedIds.size());
+        for (std::size_t i = 0; i < ChangedIds.size(); ++i) {
+            const ObjId id = ChangedIds[i];
+            auto lock = Lock(id);
+            rStore.ClearDirty(id);
+            ChangedRotations[i] = rStore.Rotation(id);
+            for (int k = 0; k < 3; ++k) Local[id].T[k] = rStore.Position(id)[k];
+        }
+
+        ChangedMatrices.resize(9 * ChangedIds.size());
+        kernels::EulerToMatrices(ChangedRotations.data(), ChangedMatrices.data(), ChangedIds.size());
+        for (std::size_t i = 0; i < ChangedIds.size(); ++i) {
+            const ObjId id = ChangedIds[i];
+            std::copy(&ChangedMatrices[9 * i], &ChangedMatrices[9 * i] + 9, Local[id].R);
+            LocalRotations[id] = ChangedRotations[i];
+            Changed[id] = 1;
+        }
+
+        MovedIds.clear();
+        if (ChangedIds.size() >= Order.size() / SweepRatio) {
+            Walk(0, static_cast<std::uint32_t>(Order.size()));
+        } else {
+            // Walk the subtree of every changed object once, in depth-first order
+            std::sort(ChangedIds.begin(), ChangedIds.end(),
+                      [this](ObjId a, ObjId b) { return OrderPos[a] < OrderPos[b]; });
+            std::uint32_t walked = 0;   // Order is walked up to here
+            for (ObjId top : ChangedIds) {
+                if (OrderPos[top] < walked) continue;   // In a subtree walked already
+                walked = SubtreeEnd[top];
+                Walk(OrderPos[top], walked);
+            }
+        }
+        ReportMoved(OnMoved);
+    }
+
+    /*!
+     * \brief Parent of an object, NoParent for a root.
+     */
+    ObjId GetParent(ObjId Id) const { return Parents[Id]; }
+
+    /*!
+     * \brief Cached world transform of an object, as of the last Update().
+     */
+    const Transform& GetWorld(ObjId Id) const { return World[Id]; }
+
+    /*!
+     * \brief Number of objects in the graph.
+     */
+    std::size_t Size() const { return Order.size(); }
+
+    /*!
+     * \brief Number of objects without a parent.
+     */
+    std::size_t GetRootCount() const { return RootCount; }
+};
+
+#endif
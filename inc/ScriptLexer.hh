@@ -0,0 +1,114 @@
+#ifndef SCRIPTLEXER_HH
+#define SCRIPTLEXER_HH
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "TokenCursor.hh"
+
+/*!
+ * \class MappedFile
+ * \brief Read-only memory mapping of a whole file.
+ */
+class MappedFile {
+private:
+    void* pData = MAP_FAILED;   //!< Start of the mapping
+    std::size_t Size = 0;       //!< Length of the file
+
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() { Close(); }
+
+    /*!
+     * \brief Maps the file.
+     * \return False if the file cannot be opened or mapped.
+     */
+    bool Open(const std::string& rPath) {
+        Close();
+        const int fd = ::open(rPath.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+
+        struct stat info;
+        if (::fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+            ::close(fd);
+            return false;
+        }
+
+        Size = static_cast<std::size_t>(info.st_size);
+        if (Size > 0) {     // An empty file cannot be mapped, it is just an empty view
+            pData = ::mmap(nullptr, Size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (pData == MAP_FAILED) {
+                ::close(fd);
+                Size = 0;
+                return false;
+            }
+            ::madvise(pData, Size, MADV_SEQUENTIAL);
+        }
+        ::close(fd);        // The mapping stays valid
+        return true;
+    }
+
+    /*!
+     * \brief Unmaps the file.
+     */
+    void Close() {
+        if (pData != MAP_FAILED) ::munmap(pData, Size);
+        pData = MAP_FAILED;
+        Size = 0;
+    }
+
+    /*!
+     * \brief Contents of the file, valid until Close().
+     */
+    std::string_view View() const {
+        return pData == MAP_FAILED ? std::string_view() : std::string_view(static_cast<const char*>(pData), Size);
+    }
+};
+
+/*!
+ * \class ScriptLexer
+ * \brief Splits a command script into lines.
+ *
+ * The lines are views into the script text: nothing is copied, and the
+ * tokens of a line are read with a TokenCursor.
+ */
+class ScriptLexer {
+private:
+    std::string_view Rest;          //!< Text after the current line
+    std::size_t LineNumber = 0;     //!< Number of the current line, from 1
+
+public:
+    explicit ScriptLexer(std::string_view Text) : Rest(Text) {}
+
+    /*!
+     * \brief Reads the next line, without the line terminator and trailing whitespace.
+     * \return False at the end of the text.
+     */
+    bool NextLine(std::string_view& rLine) {
+        if (Rest.empty()) return false;
+
+        const std::size_t end = Rest.find('\n');
+        rLine = Rest.substr(0, end);
+        Rest.remove_prefix(end == std::string_view::npos ? Rest.size() : end + 1);
+        ++LineNumber;
+
+        while (!rLine.empty() && (rLine.back() == '\r' || rLine.back() == ' ' || rLine.back() == '\t')) {
+            rLine.remove_suffix(1);
+        }
+        return true;
+    }
+
+    /*!
+     * \brief Number of the line returned by the last NextLine(), from 1.
+     */
+    std::size_t GetLineNumber() const { return LineNumber; }
+};
+
+#endif
@@ -2,21 +2,73 @@
 #define SENDER_HH
 
 #include <string>
+#include <string_view>
 #include <mutex>
+#include <condition_variable>
 #include <atomic>
 #include <iostream>
 #include <cstring>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <thread>
 #include <unistd.h>
+#include <fcntl.h>
+#include <sys/uio.h>      // For writev
+#include <sys/epoll.h>    // For the asynchronous I/O thread
+#include <sys/eventfd.h>  // For waking up the I/O thread
 #include <netinet/in.h>     // For sockaddr_in
 #include <sys/socket.h>     // For socket operations
 #include <arpa/inet.h>      // For inet_addr
 #include "AbstractComChannel.hh"
+#include "MpscRing.hh"
+#include "Logger.hh"
+#include "ProtocolEncoder.hh"
+#include "BinaryProtocol.hh"
+
+/*!
+ * \brief Policy applied by the asynchronous Sender when its queue is full.
+ */
+enum class BackpressurePolicy {
+    Block,        //!< Producers sleep until the I/O thread takes messages from the queue
+    DropOldest,   //!< A newer update of an object replaces its older, still queued one
+    Coalesce      //!< Like DropOldest, additionally every drained batch keeps one update per object
+};
+
+/*!
+ * \brief Counters of the Sender.
+ */
+struct SenderStats {
+    std::size_t QueueDepth = 0;       //!< Messages waiting in the queue (asynchronous mode)
+    std::size_t PeakQueueDepth = 0;   //!< Highest observed queue depth (asynchronous mode)
+    std::uint64_t Queued = 0;         //!< Messages accepted by the queue (asynchronous mode)
+    std::uint64_t Dropped = 0;        //!< Updates discarded because a newer one superseded them
+    std::uint64_t UpdatesSuppressed = 0;  //!< Object updates not sent because nothing changed
+    std::uint64_t UpdateBytesFull = 0;    //!< Bytes the object updates would take if sent in full
+    std::uint64_t UpdateBytesSent = 0;    //!< Bytes of the object updates actually encoded
+};
 
 /*!
  * \brief Handles communication with the graphical server.
  *
  * This class provides functionality to send preformatted commands
  * to the graphical server using a network connection.
+ *
+ * Object states passed to SendAddObj()/SendObjUpdate() are encoded
+ * either as text commands or, after SetWireFormat(WireFormat::Binary),
+ * as the compact records described in BinaryProtocol.hh.
+ *
+ * By default messages are written synchronously by the calling thread.
+ * After StartAsync() they are pushed into a lock-free queue and written
+ * to a non-blocking socket by a dedicated I/O thread, so a slow server
+ * does not stall the producers. Under BackpressurePolicy::Block the
+ * messages are only staged while the channel is locked and pushed by
+ * UnlockAccess() after releasing it, so a producer waiting for room in
+ * the queue never holds the channel.
  */
 class Sender : public AbstractComChannel {
 private:
@@ -24,21 +76,96 @@ private:
     std::mutex Mutex;                  // Mutex for thread safety
     std::atomic<bool> Connected;       // Indicates whether the connection is active
 
+    /*!
+     * \brief Message waiting to be sent.
+     */
+    struct OutMessage {
+        std::string ObjName;           // Object the update refers to, empty for other commands
+        std::string Text;              // Preformatted command
+        std::uint64_t Seq = 0;         // Age of the message (set by the I/O thread for queued ones)
+    };
+
+    /*!
+     * \brief Place of an object's update in the frame being collected.
+     */
+    struct FrameSlot {
+        std::uint64_t Frame = 0;       // Frame in which Index was assigned
+        std::size_t Index = 0;         // Index in FrameMessages
+    };
+
+    bool FrameBatching;                // Coalesce updates sent between BeginFrame and EndFrame
+    bool InFrame;                      // A frame is being collected
+    std::uint64_t FrameNumber;         // Number of the frame being collected
+    std::size_t FrameUsed;             // Messages of the current frame (the first FrameUsed entries of FrameMessages)
+    std::vector<OutMessage> FrameMessages;                  // Reused between frames, so their buffers keep their capacity
+    std::unordered_map<std::string, FrameSlot> FrameSlots;  // Object name -> slot, kept between frames
+    std::vector<iovec> FrameChunks;    // Scratch array for writev
+
+    WireFormat Format;                 // Encoding of the connection
+    ProtocolEncoder TextEncoder;       // Encodes text commands (used under the channel lock)
+    BinaryEncoder BinEncoder;          // Encodes binary records (used under the channel lock)
+    std::unordered_map<std::string, std::uint32_t> ObjIds;  // Object name -> id bound by AddObj (binary format)
+
+    /*!
+     * \brief State of an object as last passed on for sending.
+     */
+    struct SentState {
+        double Values[wire::DeltaFieldCount] = {};   // Shift x, y, z, rotation x, y, z
+        std::uint8_t Known = 0;        // Values which have been sent at least once (bit per value)
+        std::uint8_t FrameMask = 0;    // Values changed during frame Frame
+        std::uint64_t Frame = 0;       // Frame in which FrameMask was collected
+    };
+
+    bool DeltaUpdates;                 // SendObjUpdate() sends only the changed values
+    double ShiftQuantum;               // Shift is rounded to multiples of this (0 - no rounding)
+    double AngleQuantum;               // Angles are rounded to multiples of this (0 - no rounding)
+    std::unordered_map<std::string, SentState> SentStates;  // Object name -> last sent state
+
+    // -- Asynchronous mode ------------------------------------------------ //
+    static constexpr std::size_t MaxPendingBytes = 64 * 1024;  // Stop draining the queue above this
+
+    std::atomic<bool> Async;           // Messages go through the queue and the I/O thread
+    BackpressurePolicy Policy;         // What to do when the queue is full
+    std::unique_ptr<MpscRing<OutMessage>> Queue;             // Outbound messages
+    std::mutex OverflowMutex;          // Guards Overflow (taken only when the queue is full)
+    std::unordered_map<std::string, OutMessage> Overflow;    // Newest update per object which did not fit
+    std::atomic<bool> OverflowPending; // Overflow is not empty
+    std::vector<OutMessage> Staged;    // Messages of the policy Block waiting for UnlockAccess() (under the channel lock)
+    std::uint64_t NextTicket;          // Turn of the next producer publishing Staged (under the channel lock)
+    std::uint64_t ServedTicket;        // Turn being published (under PublishMutex)
+    std::mutex PublishMutex;           // Paired with PublishTurn
+    std::condition_variable PublishTurn;  // Signalled when a producer has published its staged messages
+    std::mutex DrainMutex;             // Paired with Drained
+    std::condition_variable Drained;   // Signalled by the I/O thread after taking messages from the queue
+    std::atomic<int> BlockedProducers; // Producers waiting on Drained (policy Block)
+    std::thread IoThread;              // Drains the queue into the socket
+    int EpollFd;                       // Waits for socket writability and wake-ups
+    int WakeFd;                        // eventfd used to wake up the I/O thread
+    std::atomic<bool> IoSleeping;      // The I/O thread is (about to be) blocked in epoll_wait
+    std::atomic<bool> StopRequested;   // The I/O thread should exit once everything is sent
+
+    std::atomic<std::size_t> PeakQueueDepth;
+    std::atomic<std::uint64_t> QueuedCount;
+    std::atomic<std::uint64_t> DroppedCount;
+    std::atomic<std::uint64_t> SuppressedCount;
+    std::atomic<std::uint64_t> UpdateBytesFull;
+    std::atomic<std::uint64_t> UpdateBytesSent;
+
     /*!
      * \brief Sends a string message through the socket.
      * \param message The message to send.
      */
-    void Send(const std::string& message) {
-        std::cout << "Send:" << message << std::endl;
+    void Send(std::string_view message) {
+        LOG_TRACE("Send:" << message);
         //std::lock_guard<std::mutex> lock(Mutex);
         ssize_t totalSent = 0;
         ssize_t toSend = message.size();
-        const char* data = message.c_str();
+        const char* data = message.data();
 
         while (toSend > 0) {
             ssize_t sent = write(Socket, data + totalSent, toSend);
             if (sent < 0) {
-                std::cerr << "*** Error sending message: " << strerror(errno) << std::endl;
+                LOG_ERROR("*** Error sending message: " << strerror(errno));
                 Connected = false;
                 return;
             }
@@ -47,11 +174,440 @@ private:
         }
     }
 
+    /*!
+     * \brief Sends all messages collected during the current frame.
+     *
+     * The messages are written with a single writev() call
+     * (split only when there are more than IOV_MAX of them).
+     */
+    void FlushFrame() {
+        std::vector<iovec>& chunks = FrameChunks;
+        chunks.clear();
+        for (std::size_t i = 0; i < FrameUsed; ++i) {
+            const std::string& text = FrameMessages[i].Text;
+            chunks.push_back(iovec{const_cast<char*>(text.data()), text.size()});
+        }
+
+        std::size_t first = 0;
+        while (first < chunks.size()) {
+            const int count = static_cast<int>(std::min<std::size_t>(chunks.size() - first, IOV_MAX));
+            ssize_t sent = writev(Socket, chunks.data() + first, count);
+            if (sent < 0) {
+                LOG_ERROR("*** Error sending message: " << strerror(errno));
+                Connected = false;
+                break;
+            }
+
+            // Skip the fully written chunks and trim a partially written one
+            while (first < chunks.size() && sent >= static_cast<ssize_t>(chunks[first].iov_len)) {
+                sent -= chunks[first].iov_len;
+                ++first;
+            }
+            if (first < chunks.size()) {
+                chunks[first].iov_base = static_cast<char*>(chunks[first].iov_base) + sent;
+                chunks[first].iov_len -= sent;
+            }
+        }
+    }
+
+    /*!
+     * \brief Takes the next free message slot of the current frame.
+     */
+    OutMessage& NextFrameMessage() {
+        if (FrameUsed == FrameMessages.size()) {
+            FrameMessages.emplace_back();
+        }
+        return FrameMessages[FrameUsed++];
+    }
+
+    /*!
+     * \brief Wakes up the I/O thread if it sleeps in epoll_wait.
+     * \param force Write to the eventfd even if the thread is not sleeping.
+     */
+    void WakeIoThread(bool force = false) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (IoSleeping.exchange(false) || force) {
+            const std::uint64_t one = 1;
+            if (write(WakeFd, &one, sizeof(one)) < 0) {
+                LOG_ERROR("*** Error waking up the I/O thread: " << strerror(errno));
+            }
+        }
+    }
+
+    /*!
+     * \brief Queues a message for the I/O thread, applying the backpressure policy.
+     * \param message The message to queue.
+     */
+    void Enqueue(OutMessage&& message) {
+        if (!Queue->TryPush(message)) {
+            if (!message.ObjName.empty() && Policy != BackpressurePolicy::Block) {
+                {
+                    std::lock_guard<std::mutex> lock(OverflowMutex);
+                    // Stamped between the queue positions claimed before and after it
+                    message.Seq = 2 * static_cast<std::uint64_t>(Queue->NextPosition());
+                    auto slot = Overflow.try_emplace(message.ObjName);
+                    if (!slot.second) ++DroppedCount;   // Older update of this object is discarded
+                    slot.first->second = std::move(message);
+                    OverflowPending = true;
+                }
+                WakeIoThread();
+                return;
+            }
+
+            BlockedProducers.fetch_add(1);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            {
+                // The push is retried under DrainMutex, so a signal sent after a pop cannot be missed
+                std::unique_lock<std::mutex> lock(DrainMutex);
+                while (!Queue->TryPush(message)) {
+                    WakeIoThread();
+                    Drained.wait(lock);
+                }
+            }
+            BlockedProducers.fetch_sub(1);
+        }
+
+        ++QueuedCount;
+        const std::size_t depth = Queue->SizeApprox();
+        std::size_t peak = PeakQueueDepth.load(std::memory_order_relaxed);
+        while (depth > peak && !PeakQueueDepth.compare_exchange_weak(peak, depth, std::memory_order_relaxed)) {}
+
+        WakeIoThread();
+    }
+
+    /*!
+     * \brief Passes a message of the asynchronous mode on for sending.
+     *
+     * Called with the channel locked. Under the policy Block the message
+     * is staged for UnlockAccess(), the other policies never wait
+     * and push it right away.
+     * \param message The message to send.
+     */
+    void Post(OutMessage&& message) {
+        if (Policy == BackpressurePolicy::Block) {
+            Staged.push_back(std::move(message));
+            return;
+        }
+        Enqueue(std::move(message));
+    }
+
+    /*!
+     * \brief Pushes the staged messages into the queue and releases the channel.
+     *
+     * Called with the channel locked. Producers publish in the order
+     * in which they release the channel, so the per-object order of the
+     * updates is kept, while waiting for their turn and for room in the
+     * queue happens without the channel lock.
+     */
+    void UnlockAndPublish() {
+        if (Staged.empty()) {
+            Mutex.unlock();
+            return;
+        }
+        std::vector<OutMessage> messages;
+        messages.swap(Staged);
+        const std::uint64_t ticket = NextTicket++;
+        Mutex.unlock();
+
+        std::unique_lock<std::mutex> lock(PublishMutex);
+        PublishTurn.wait(lock, [&] { return ServedTicket == ticket; });
+        lock.unlock();
+        for (auto& message : messages) {
+            Enqueue(std::move(message));
+        }
+        lock.lock();
+        ++ServedTicket;
+        lock.unlock();
+        PublishTurn.notify_all();
+    }
+
+    /*!
+     * \brief Removes from the batch the updates replaced by a newer one in the overflow table.
+     *
+     * An older update of the object still in the queue after this batch
+     * is dropped later by the per-object check in IoLoop(), so the older
+     * update is never written once the newer one is in the table.
+     * Called with OverflowMutex held.
+     * \param batch Messages taken from the queue.
+     */
+    void DropSuperseded(std::vector<OutMessage>& batch) {
+        std::size_t kept = 0;
+        for (std::size_t i = 0; i < batch.size(); ++i) {
+            if (!batch[i].ObjName.empty()) {
+                auto newer = Overflow.find(batch[i].ObjName);
+                if (newer != Overflow.end() && newer->second.Seq > batch[i].Seq) {
+                    ++DroppedCount;
+                    continue;
+                }
+            }
+            if (kept != i) batch[kept] = std::move(batch[i]);
+            ++kept;
+        }
+        batch.resize(kept);
+    }
+
+    /*!
+     * \brief Leaves only the newest update of each object in the batch.
+     * \param batch Messages taken from the queue and the overflow table.
+     */
+    void CoalesceBatch(std::vector<OutMessage>& batch) {
+        std::unordered_map<std::string, std::size_t> newest;
+        for (std::size_t i = 0; i < batch.size(); ++i) {
+            if (batch[i].ObjName.empty()) continue;
+            auto slot = newest.try_emplace(batch[i].ObjName, i);
+            if (batch[i].Seq > batch[slot.first->second].Seq) slot.first->second = i;
+        }
+
+        std::size_t kept = 0;
+        for (std::size_t i = 0; i < batch.size(); ++i) {
+            if (!batch[i].ObjName.empty() && newest[batch[i].ObjName] != i) {
+                ++DroppedCount;
+                continue;
+            }
+            if (kept != i) batch[kept] = std::move(batch[i]);
+            ++kept;
+        }
+        batch.resize(kept);
+    }
+
+    /*!
+     * \brief Main loop of the I/O thread.
+     */
+    void IoLoop() {
+        std::vector<OutMessage> batch;
+        std::unordered_map<std::string, std::uint64_t> lastSent;   // Age of the last update written per object
+        std::string pending;            // Bytes accepted from the queue but not written yet
+        std::size_t pendingOffset = 0;
+        bool waitWritable = false;
+
+        for (;;) {
+            // Take messages only while the socket keeps up, otherwise the queue fills and the policy applies
+            if (pending.size() - pendingOffset < MaxPendingBytes) {
+                OutMessage message;
+                std::size_t position;
+                while (Queue->TryPop(message, &position)) {
+                    message.Seq = 2 * static_cast<std::uint64_t>(position) + 1;
+                    batch.push_back(std::move(message));
+                }
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (!batch.empty() && BlockedProducers.load() > 0) {
+                    { std::lock_guard<std::mutex> lock(DrainMutex); }
+                    Drained.notify_all();
+                }
+                if (OverflowPending.exchange(false)) {
+                    std::lock_guard<std::mutex> lock(OverflowMutex);
+                    DropSuperseded(batch);
+                    for (auto& entry : Overflow) {
+                        batch.push_back(std::move(entry.second));
+                    }
+                    Overflow.clear();
+                }
+                if (Policy == BackpressurePolicy::Coalesce) {
+                    CoalesceBatch(batch);
+                }
+                for (const auto& out : batch) {
+                    if (!out.ObjName.empty()) {
+                        // An update older than the one already written was superseded while queued
+                        std::uint64_t& last = lastSent[out.ObjName];
+                        if (out.Seq < last) {
+                            ++DroppedCount;
+                            continue;
+                        }
+                        last = out.Seq;
+                    }
+                    pending += out.Text;
+                }
+                batch.clear();
+            }
+
+            if (!Connected) {
+                pending.clear();
+                pendingOffset = 0;
+            }
+
+            if (pendingOffset < pending.size()) {
+                const ssize_t sent = write(Socket, pending.data() + pendingOffset, pending.size() - pendingOffset);
+                if (sent > 0) {
+                    pendingOffset += sent;
+                } else if (sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                    LOG_ERROR("*** Error sending message: " << strerror(errno));
+                    Connected = false;
+                }
+            }
+            if (pendingOffset == pending.size()) {
+                pending.clear();
+                pendingOffset = 0;
+            }
+
+            const bool hasPending = !pending.empty();
+            if (hasPending != waitWritable) {
+                epoll_event event = {};
+                event.events = hasPending ? static_cast<std::uint32_t>(EPOLLOUT) : 0u;
+                event.data.fd = Socket;
+                epoll_ctl(EpollFd, EPOLL_CTL_MOD, Socket, &event);
+                waitWritable = hasPending;
+            }
+
+            if (!hasPending && StopRequested && Queue->SizeApprox() == 0 && !OverflowPending) {
+                return;
+            }
+
+            // Announce sleeping, then re-check so that a concurrent push is not missed
+            IoSleeping = true;
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if ((Queue->SizeApprox() > 0 || OverflowPending) && (pending.size() - pendingOffset < MaxPendingBytes)) {
+                IoSleeping = false;
+                continue;
+            }
+            if (!hasPending && StopRequested) {
+                IoSleeping = false;
+                continue;
+            }
+
+            epoll_event events[2];
+            const int ready = epoll_wait(EpollFd, events, 2, -1);
+            IoSleeping = false;
+
+            for (int i = 0; i < ready; ++i) {
+                if (events[i].data.fd == WakeFd) {
+                    std::uint64_t counter;
+                    if (read(WakeFd, &counter, sizeof(counter)) < 0 && errno != EAGAIN) {
+                        LOG_ERROR("*** Error reading eventfd: " << strerror(errno));
+                    }
+                }
+            }
+        }
+    }
+
+    /*!
+     * \brief Sends an already encoded command, which never replaces another one.
+     *
+     * In the synchronous mode the bytes are written directly from the
+     * caller's buffer.
+     * \param command The encoded command.
+     */
+    void DispatchCommand(std::string_view command) {
+        if (InFrame) {
+            OutMessage& message = NextFrameMessage();   // Keeps its place, never coalesced
+            message.ObjName.clear();
+            message.Text.assign(command);
+            return;
+        }
+        if (!Connected) {
+            LOG_ERROR("Sender is not connected to the server.");
+            return;
+        }
+        if (Async) {
+            Post(OutMessage{std::string(), std::string(command)});
+            return;
+        }
+        Send(command);
+    }
+
+    /*!
+     * \brief Sends an already encoded update of an object.
+     *
+     * Within a frame it replaces the previous update of the same object.
+     * \param objName Name of the updated object.
+     * \param message The encoded update.
+     */
+    void DispatchUpdate(const std::string& objName, std::string_view message) {
+        if (!InFrame) {
+            if (Async && Connected) {
+                Post(OutMessage{objName, std::string(message)});
+                return;
+            }
+            DispatchCommand(message);
+            return;
+        }
+
+        FrameSlot& slot = FrameSlots[objName];
+        if (slot.Frame == FrameNumber) {
+            FrameMessages[slot.Index].Text.assign(message);   // The last update of an object wins
+            return;
+        }
+
+        slot.Frame = FrameNumber;
+        slot.Index = FrameUsed;
+        OutMessage& out = NextFrameMessage();
+        out.ObjName = objName;
+        out.Text.assign(message);
+    }
+
+    /*!
+     * \brief Encodes an update with exactly the fields the caller has set.
+     * \return View of the encoder's buffer.
+     */
+    std::string_view EncodeUpdate(const std::string& objName, const ObjUpdate& upd) {
+        if (Format == WireFormat::Binary) {
+            auto id = ObjIds.find(objName);
+            if (id != ObjIds.end()) {
+                BinEncoder.UpdateObj(id->second, upd);
+                return BinEncoder.View();
+            }
+            TextEncoder.UpdateObj(objName, upd);
+            BinEncoder.Text(TextEncoder.View());
+            return BinEncoder.View();
+        }
+        TextEncoder.UpdateObj(objName, upd);
+        return TextEncoder.View();
+    }
+
+    /*!
+     * \brief Size EncodeUpdate() would return for the update, computed without encoding it.
+     */
+    std::size_t EncodedUpdateSize(const std::string& objName, const ObjUpdate& upd) const {
+        if (Format == WireFormat::Binary) {
+            if (ObjIds.count(objName)) return wire::UpdateObjSize;
+            return wire::TextHeaderSize + ProtocolEncoder::UpdateObjLength(objName, upd);
+        }
+        return ProtocolEncoder::UpdateObjLength(objName, upd);
+    }
+
+    /*!
+     * \brief Encodes the values of a tracked state selected by mask.
+     *
+     * The binary format sends exactly the selected values, the text
+     * format sends every triple containing at least one of them.
+     * \return View of the encoder's buffer.
+     */
+    std::string_view EncodeDelta(const std::string& objName, const SentState& state, std::uint8_t mask) {
+        if (Format == WireFormat::Binary) {
+            auto id = ObjIds.find(objName);
+            if (id != ObjIds.end()) {
+                BinEncoder.DeltaObj(id->second, mask, state.Values);
+                return BinEncoder.View();
+            }
+        }
+
+        ObjUpdate upd;
+        if (mask & 0x07) upd.Fields |= ObjUpdate::HasShift;
+        if (mask & 0x38) upd.Fields |= ObjUpdate::HasRotation;
+        for (int i = 0; i < 3; ++i) {
+            upd.Shift[i] = state.Values[i];
+            upd.RotXYZ_deg[i] = state.Values[3 + i];
+        }
+        return EncodeUpdate(objName, upd);
+    }
+
+    /*!
+     * \brief Rounds a value to a multiple of quantum (unless quantum is 0).
+     */
+    static double Quantize(double value, double quantum) {
+        return quantum > 0 ? std::round(value / quantum) * quantum + 0.0 : value;   // + 0.0 turns -0 into 0
+    }
+
 public:
     /*!
      * \brief Constructor.
      */
-    Sender() : Socket(0), Connected(false) {}
+    Sender() : Socket(0), Connected(false), FrameBatching(false), InFrame(false), FrameNumber(1), FrameUsed(0),
+               Format(WireFormat::Text), DeltaUpdates(false), ShiftQuantum(0), AngleQuantum(0),
+               Async(false), Policy(BackpressurePolicy::Block), OverflowPending(false),
+               NextTicket(0), ServedTicket(0), BlockedProducers(0),
+               EpollFd(-1), WakeFd(-1), IoSleeping(false), StopRequested(false),
+               PeakQueueDepth(0), QueuedCount(0), DroppedCount(0),
+               SuppressedCount(0), UpdateBytesFull(0), UpdateBytesSent(0) {}
 
     /*!
      * \brief Establishes a connection to the server.
@@ -63,7 +619,7 @@ public:
         Socket = socket(AF_INET, SOCK_STREAM, 0);
 
         if (Socket < 0) {
-            std::cerr << "*** Error opening socket.\n";
+            LOG_ERROR("*** Error opening socket.");
             return false;
         }
 
@@ -73,7 +629,7 @@ public:
         serverAddress.sin_addr.s_addr = inet_addr(ipAddress.c_str());
 
         if (connect(Socket, (struct sockaddr*)&serverAddress, sizeof(serverAddress)) < 0) {
-            std::cerr << "*** Unable to connect to server.\n";
+            LOG_ERROR("*** Unable to connect to server.");
             return false;
         }
 
@@ -82,16 +638,310 @@ public:
     }
 
     /*!
-     * \brief Sends a preformatted command to the server.
+     * \brief Sends a preformatted text command to the server.
+     *
+     * In the synchronous text mode the command is written directly from
+     * the caller's buffer. In the binary format it is wrapped in a Text record.
      * \param command The command string to send.
      */
-    void SendCommand(const std::string& command) {
-        std::cout << "SendCommand:" << command << std::endl;
+    void SendCommand(std::string_view command) {
+        LOG_TRACE("SendCommand:" << command);
+        if (Format == WireFormat::Binary) {
+            BinEncoder.Text(command);
+            DispatchCommand(BinEncoder.View());
+            return;
+        }
+        DispatchCommand(command);
+    }
+
+    /*!
+     * \brief Selects the encoding of the connection.
+     *
+     * Must be called after Connect() and before anything else is sent.
+     * Selecting the binary format sends the hello announcing it
+     * to the server, after which the format cannot be changed back.
+     * \param format The encoding to use.
+     * \return True if the format is in effect.
+     */
+    bool SetWireFormat(WireFormat format) {
+        if (format == Format) return true;
+        if (Format == WireFormat::Binary) {
+            LOG_ERROR("The binary wire format cannot be switched off.");
+            return false;
+        }
+        if (!Connected) {
+            LOG_ERROR("Sender is not connected to the server.");
+            return false;
+        }
+
+        BinEncoder.Hello();
+        DispatchCommand(BinEncoder.View());
+        Format = format;
+        return true;
+    }
+
+    /*!
+     * \brief Switches the sender to the asynchronous mode.
+     *
+     * The socket is made non-blocking and a dedicated I/O thread is
+     * started. From now on producers only push messages into a bounded
+     * lock-free queue. The mutex guarding the overflow table is taken
+     * only when the queue is full and the policy is not Block. Under
+     * the policy Block the messages are pushed by UnlockAccess(), so the
+     * channel must be released with it (or with ChannelAccess), not by
+     * unlocking UseGuard() directly.
+     * \param capacity Capacity of the queue (rounded up to a power of two).
+     * \param policy What to do when the queue is full.
+     * \return True if the I/O thread has been started.
+     */
+    bool StartAsync(std::size_t capacity = 4096, BackpressurePolicy policy = BackpressurePolicy::Coalesce) {
+        if (Async) return true;
         if (!Connected) {
-            std::cerr << "Sender is not connected to the server.\n";
+            LOG_ERROR("Sender is not connected to the server.");
+            return false;
+        }
+
+        EpollFd = epoll_create1(EPOLL_CLOEXEC);
+        WakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (EpollFd < 0 || WakeFd < 0) {
+            LOG_ERROR("*** Error creating epoll/eventfd: " << strerror(errno));
+            StopAsync();
+            return false;
+        }
+
+        epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.fd = WakeFd;
+        epoll_ctl(EpollFd, EPOLL_CTL_ADD, WakeFd, &event);
+
+        event.events = 0;   // EPOLLOUT is armed only when there is unsent data
+        event.data.fd = Socket;
+        if (epoll_ctl(EpollFd, EPOLL_CTL_ADD, Socket, &event) < 0) {
+            LOG_ERROR("*** Error registering socket in epoll: " << strerror(errno));
+            StopAsync();
+            return false;
+        }
+
+        fcntl(Socket, F_SETFL, fcntl(Socket, F_GETFL) | O_NONBLOCK);
+
+        Queue.reset(new MpscRing<OutMessage>(capacity));
+        Policy = policy;
+        StopRequested = false;
+        Async = true;
+        IoThread = std::thread(&Sender::IoLoop, this);
+        return true;
+    }
+
+    /*!
+     * \brief Sends everything still queued and returns to the synchronous mode.
+     *
+     * Must not be called while other threads are still sending.
+     */
+    void StopAsync() {
+        if (!Staged.empty() && Queue) {
+            for (auto& message : Staged) {
+                Enqueue(std::move(message));
+            }
+            Staged.clear();
+        }
+        if (IoThread.joinable()) {
+            StopRequested = true;
+            WakeIoThread(true);
+            IoThread.join();
+        }
+        if (Async) {
+            fcntl(Socket, F_SETFL, fcntl(Socket, F_GETFL) & ~O_NONBLOCK);
+            Async = false;
+        }
+        if (EpollFd >= 0) { close(EpollFd); EpollFd = -1; }
+        if (WakeFd >= 0) { close(WakeFd); WakeFd = -1; }
+    }
+
+    /*!
+     * \brief Returns the counters of the asynchronous mode and of the delta updates.
+     */
+    SenderStats GetStats() const {
+        SenderStats stats;
+        stats.QueueDepth = Queue ? Queue->SizeApprox() : 0;
+        stats.PeakQueueDepth = PeakQueueDepth;
+        stats.Queued = QueuedCount;
+        stats.Dropped = DroppedCount;
+        stats.UpdatesSuppressed = SuppressedCount;
+        stats.UpdateBytesFull = UpdateBytesFull;
+        stats.UpdateBytesSent = UpdateBytesSent;
+        return stats;
+    }
+
+    /*!
+     * \brief Enables or disables the frame-batching mode.
+     *
+     * In this mode updates passed to SendUpdate() between BeginFrame()
+     * and EndFrame() are coalesced per object (the last one wins) and
+     * written to the socket with one system call per frame.
+     * \param enable True to enable batching.
+     */
+    void SetFrameBatching(bool enable) {
+        FrameBatching = enable;
+    }
+
+    /*!
+     * \brief Implements AbstractComChannel::BeginFrame.
+     */
+    void BeginFrame() override {
+        InFrame = FrameBatching;
+    }
+
+    /*!
+     * \brief Implements AbstractComChannel::EndFrame.
+     */
+    void EndFrame() override {
+        if (InFrame && FrameUsed > 0) {
+            if (Connected && Async) {
+                for (std::size_t i = 0; i < FrameUsed; ++i) {
+                    Post(OutMessage{FrameMessages[i].ObjName, std::move(FrameMessages[i].Text)});
+                }
+            } else if (Connected) {
+                FlushFrame();
+            } else {
+                LOG_ERROR("Sender is not connected to the server.");
+            }
+        }
+        FrameUsed = 0;
+        ++FrameNumber;      // Invalidates all slots assigned during this frame
+        InFrame = false;
+    }
+
+    /*!
+     * \brief Implements AbstractComChannel::SendUpdate.
+     */
+    void SendUpdate(const std::string& objName, std::string_view message) override {
+        LOG_TRACE("SendUpdate:" << message);
+        if (Format == WireFormat::Binary) {
+            BinEncoder.Text(message);
+            DispatchUpdate(objName, BinEncoder.View());
             return;
         }
-        Send(command);
+        DispatchUpdate(objName, message);
+    }
+
+    /*!
+     * \brief Implements AbstractComChannel::SendAddObj.
+     *
+     * In the binary format the name is bound to a new id here,
+     * later updates of the object refer to it by that id.
+     */
+    void SendAddObj(const std::string& objName, const ObjDefinition& def) override {
+        if (DeltaUpdates) {
+            SentState& state = SentStates[objName];
+            for (int i = 0; i < 3; ++i) {
+                state.Values[i] = def.Shift[i];
+                state.Values[3 + i] = def.RotXYZ_deg[i];
+            }
+            state.Known = 0x3f;
+        }
+
+        if (Format == WireFormat::Binary) {
+            const auto id = ObjIds.try_emplace(objName, static_cast<std::uint32_t>(ObjIds.size())).first->second;
+            BinEncoder.AddObj(id, objName, def);
+            DispatchCommand(BinEncoder.View());
+            return;
+        }
+        TextEncoder.AddObj(objName, def);
+        LOG_TRACE("SendAddObj:" << TextEncoder.View());
+        DispatchCommand(TextEncoder.View());
+    }
+
+    /*!
+     * \brief Implements AbstractComChannel::SendObjUpdate.
+     *
+     * In the binary format an object without an id (never added with
+     * SendAddObj) is updated with its text command wrapped in a Text record.
+     *
+     * With SetDeltaUpdates() enabled the values are first quantized and
+     * compared with the last state sent for the object. Unchanged values
+     * are left out and an update which changes nothing is not sent at all.
+     * Within a frame the changes of all updates of the object are merged.
+     * When the asynchronous queue may drop updates (policy other than
+     * Block), every sent update carries the complete known state instead,
+     * so that dropping an older one never loses a change.
+     */
+    void SendObjUpdate(const std::string& objName, const ObjUpdate& upd) override {
+        if (!DeltaUpdates) {
+            const std::string_view message = EncodeUpdate(objName, upd);
+            LOG_TRACE("SendObjUpdate:" << message);
+            DispatchUpdate(objName, message);
+            return;
+        }
+
+        ObjUpdate quantized = upd;
+        for (int i = 0; i < 3; ++i) {
+            quantized.Shift[i] = Quantize(upd.Shift[i], ShiftQuantum);
+            quantized.RotXYZ_deg[i] = Quantize(upd.RotXYZ_deg[i], AngleQuantum);
+        }
+        UpdateBytesFull += EncodedUpdateSize(objName, quantized);
+
+        const std::uint8_t offered = ((quantized.Fields & ObjUpdate::HasShift) ? 0x07 : 0)
+                                   | ((quantized.Fields & ObjUpdate::HasRotation) ? 0x38 : 0);
+        const double values[wire::DeltaFieldCount] = {
+            quantized.Shift[0], quantized.Shift[1], quantized.Shift[2],
+            quantized.RotXYZ_deg[0], quantized.RotXYZ_deg[1], quantized.RotXYZ_deg[2]
+        };
+
+        SentState& state = SentStates[objName];
+        std::uint8_t changed = 0;
+        for (int i = 0; i < wire::DeltaFieldCount; ++i) {
+            const std::uint8_t bit = static_cast<std::uint8_t>(1u << i);
+            if ((offered & bit) && (!(state.Known & bit) || state.Values[i] != values[i])) {
+                state.Values[i] = values[i];
+                changed |= bit;
+            }
+        }
+        state.Known |= changed;
+
+        if (InFrame) {
+            if (state.Frame != FrameNumber) {
+                state.Frame = FrameNumber;
+                state.FrameMask = 0;
+            }
+            state.FrameMask |= changed;
+            changed = state.FrameMask;   // Replaces the object's earlier update of this frame
+        }
+        if (!changed) {
+            ++SuppressedCount;
+            return;
+        }
+
+        const bool lossy = Async && Policy != BackpressurePolicy::Block;
+        const std::string_view message = EncodeDelta(objName, state, lossy ? state.Known : changed);
+        UpdateBytesSent += message.size();
+        LOG_TRACE("SendObjUpdate:" << message);
+        DispatchUpdate(objName, message);
+    }
+
+    /*!
+     * \brief Enables sending only the changed values of object updates.
+     *
+     * Must be enabled before the objects are added, so that their
+     * initial state is known.
+     * \param enable True to track the last sent state of every object.
+     */
+    void SetDeltaUpdates(bool enable) {
+        DeltaUpdates = enable;
+        if (!enable) SentStates.clear();
+    }
+
+    /*!
+     * \brief Sets the precision of the values sent in delta updates.
+     *
+     * Values are rounded to multiples of the given steps before they are
+     * compared with the last sent state, so changes smaller than half
+     * a step are not sent. The scene itself keeps the exact values.
+     * \param shiftStep Step of the shift (0 - no rounding).
+     * \param angleStep Step of the angles in degrees (0 - no rounding).
+     */
+    void SetQuantization(double shiftStep, double angleStep) {
+        ShiftQuantum = shiftStep;
+        AngleQuantum = angleStep;
     }
 
     /*!
@@ -118,9 +968,13 @@ public:
 
     /*!
      * \brief Implements AbstractComChannel::UnlockAccess.
+     *
+     * Under the policy Block it also pushes the messages staged while
+     * the channel was locked, waiting for room in the queue only after
+     * the channel has been released.
      */
     void UnlockAccess() override {
-        Mutex.unlock();
+        UnlockAndPublish();
     }
 
     /*!
@@ -134,6 +988,7 @@ public:
      * \brief Destructor.
      */
     ~Sender() {
+        StopAsync();
         if (Socket >= 0) {
             close(Socket);
         }
@@ -1,9 +1,11 @@
 #ifndef SET4LIBINTERFACES_HH
 #define SET4LIBINTERFACES_HH
 
-#include <vector>
+#include <iostream>
 #include <memory>
-#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
 #include "LibInterface.hh"
 
 /*!
@@ -12,7 +14,9 @@
  *
  * This class provides methods to load, access, and manage multiple libraries, each
  * represented by a LibInterface object. It allows loading multiple command plugins
- * and accessing specific commands by name.
+ * and accessing specific commands by name. Command names are resolved
+ * through a hash table built while the libraries are loaded, so looking
+ * up a command costs one hash of its name.
  */
 class Set4LibInterfaces {
 public:
@@ -29,6 +33,12 @@ public:
             return false;
         }
 
+        if (!byCommand.emplace(cmdName, libInterface.get()).second) {
+            std::cerr << "Command " << cmdName << " is already provided by another library, "
+                      << libName << " ignored" << std::endl;
+            return true;
+        }
+
         interfaces.push_back(std::move(libInterface));  // Add to the collection
 
         return true;
@@ -40,13 +50,8 @@ public:
      * \return Pointer to the LibInterface object if found, nullptr otherwise.
      */
     LibInterface* getInterface(const std::string& cmdName) const {
-        for (const auto& interface : interfaces) {
-            if (interface->getCommandName() == cmdName) {  // Match the command name
-                return interface.get();
-            }
-        }
-
-        return nullptr;
+        auto it = byCommand.find(cmdName);
+        return it != byCommand.end() ? it->second : nullptr;
     }
 
     /*!
@@ -63,7 +68,8 @@ public:
     }
 
 private:
-    std::list<std::unique_ptr<LibInterface>> interfaces;  ///< Collection of loaded LibInterface objects
+    std::vector<std::unique_ptr<LibInterface>> interfaces;  ///< Collection of loaded LibInterface objects
+    std::unordered_map<std::string, LibInterface*> byCommand; ///< Command name -> library providing it
 };
 
 #endif
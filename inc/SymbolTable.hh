@@ -0,0 +1,215 @@
+#ifndef SYMBOLTABLE_HH
+#define SYMBOLTABLE_HH
+
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+/*!
+ * \class SymbolTable
+ * \brief Numeric constants of a script (`#define`), looked up by name without copying it.
+ *
+ * An open-addressing hash table with linear probing: lookups hash the
+ * string_view of a token once and compare names only on a hash match.
+ * The table also evaluates constant expressions such as
+ * `ROTATE_SPEED*2`, so a script pays for them once, at load time.
+ */
+class SymbolTable {
+private:
+    /*!
+     * \brief Slot of the table, unused while Name is empty.
+     */
+    struct Symbol {
+        std::uint64_t Hash = 0;
+        std::string Name;
+        double Value = 0;
+    };
+
+    std::vector<Symbol> Slots = std::vector<Symbol>(16);   //!< Capacity is a power of two
+    std::size_t Count = 0;                                  //!< Number of defined symbols
+
+    /*!
+     * \brief FNV-1a hash of a name.
+     */
+    static std::uint64_t HashOf(std::string_view Name) {
+        std::uint64_t hash = 1469598103934665603ull;
+        for (char c : Name) {
+            hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+        }
+        return hash;
+    }
+
+    /*!
+     * \brief Slot holding the name, or the free slot where it belongs.
+     */
+    std::size_t Probe(std::string_view Name, std::uint64_t Hash) const {
+        const std::size_t mask = Slots.size() - 1;
+        std::size_t index = static_cast<std::size_t>(Hash) & mask;
+        while (!Slots[index].Name.empty() && (Slots[index].Hash != Hash || Slots[index].Name != Name)) {
+            index = (index + 1) & mask;
+        }
+        return index;
+    }
+
+    /*!
+     * \brief Doubles the capacity and reinserts the symbols.
+     */
+    void Grow() {
+        std::vector<Symbol> old(2 * Slots.size());
+        old.swap(Slots);
+        for (Symbol& symbol : old) {
+            if (!symbol.Name.empty()) {
+                Slots[Probe(symbol.Name, symbol.Hash)] = std::move(symbol);
+            }
+        }
+    }
+
+    /*!
+     * \brief Recursive descent evaluator of the constant expressions.
+     *
+     * Grammar: sum := product (('+'|'-') product)*,
+     *          product := unary (('*'|'/') unary)*,
+     *          unary := ('+'|'-') unary | '(' sum ')' | number | name.
+     */
+    class Parser {
+    private:
+        const SymbolTable& rTable;
+        std::string_view Text;
+        std::size_t Pos = 0;
+
+        static bool IsNameStart(char c) {
+            return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+        }
+        static bool IsNameChar(char c) {
+            return IsNameStart(c) || (c >= '0' && c <= '9') || c == '.';
+        }
+
+        void SkipSpace() {
+            while (Pos < Text.size() && (Text[Pos] == ' ' || Text[Pos] == '\t' || Text[Pos] == '\r')) ++Pos;
+        }
+
+        bool Accept(char c) {
+            SkipSpace();
+            if (Pos < Text.size() && Text[Pos] == c) {
+                ++Pos;
+                return true;
+            }
+            return false;
+        }
+
+        bool Unary(double& rValue) {
+            if (Accept('-')) {
+                if (!Unary(rValue)) return false;
+                rValue = -rValue;
+                return true;
+            }
+            if (Accept('+')) return Unary(rValue);
+            if (Accept('(')) return Sum(rValue) && Accept(')');
+
+            SkipSpace();
+            if (Pos < Text.size() && IsNameStart(Text[Pos])) {
+                const std::size_t begin = Pos;
+                while (Pos < Text.size() && IsNameChar(Text[Pos])) ++Pos;
+                const double* pValue = rTable.Find(Text.substr(begin, Pos - begin));
+                if (!pValue) return false;
+                rValue = *pValue;
+                return true;
+            }
+
+            const auto result = std::from_chars(Text.data() + Pos, Text.data() + Text.size(), rValue);
+            if (result.ec != std::errc()) return false;
+            Pos = static_cast<std::size_t>(result.ptr - Text.data());
+            return true;
+        }
+
+        bool Product(double& rValue) {
+            if (!Unary(rValue)) return false;
+            for (;;) {
+                double rhs;
+                if (Accept('*')) {
+                    if (!Unary(rhs)) return false;
+                    rValue *= rhs;
+                } else if (Accept('/')) {
+                    if (!Unary(rhs)) return false;
+                    rValue /= rhs;
+                } else {
+                    return true;
+                }
+            }
+        }
+
+        bool Sum(double& rValue) {
+            if (!Product(rValue)) return false;
+            for (;;) {
+                double rhs;
+                if (Accept('+')) {
+                    if (!Product(rhs)) return false;
+                    rValue += rhs;
+                } else if (Accept('-')) {
+                    if (!Product(rhs)) return false;
+                    rValue -= rhs;
+                } else {
+                    return true;
+                }
+            }
+        }
+
+    public:
+        Parser(const SymbolTable& rSymbols, std::string_view Expr) : rTable(rSymbols), Text(Expr) {}
+
+        bool Parse(double& rValue) {
+            if (!Sum(rValue)) return false;
+            SkipSpace();
+            return Pos == Text.size();
+        }
+    };
+
+public:
+    /*!
+     * \brief Defines a constant or changes its value.
+     */
+    void Define(std::string_view Name, double Value) {
+        if (Name.empty()) return;
+        const std::uint64_t hash = HashOf(Name);
+        std::size_t index = Probe(Name, hash);
+        if (Slots[index].Name.empty()) {
+            if (2 * (Count + 1) > Slots.size()) {   // Keep the load factor at most 1/2
+                Grow();
+                index = Probe(Name, hash);
+            }
+            Slots[index].Hash = hash;
+            Slots[index].Name.assign(Name.data(), Name.size());
+            ++Count;
+        }
+        Slots[index].Value = Value;
+    }
+
+    /*!
+     * \brief Value of a constant, nullptr if it is not defined.
+     */
+    const double* Find(std::string_view Name) const {
+        if (Count == 0 || Name.empty()) return nullptr;
+        const Symbol& symbol = Slots[Probe(Name, HashOf(Name))];
+        return symbol.Name.empty() ? nullptr : &symbol.Value;
+    }
+
+    /*!
+     * \brief Evaluates an expression of numbers and constants with + - * / and parentheses.
+     * \return False if the expression is malformed or uses an undefined constant.
+     */
+    bool Evaluate(std::string_view Expr, double& rValue) const {
+        return Parser(*this, Expr).Parse(rValue);
+    }
+
+    /*!
+     * \brief Number of defined constants.
+     */
+    std::size_t Size() const { return Count; }
+};
+
+#endif
@@ -0,0 +1,185 @@
+#ifndef TIMERWHEEL_HH
+#define TIMERWHEEL_HH
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/*!
+ * \class TimerWheel
+ * \brief Hierarchical timing wheel of one-shot timers.
+ *
+ * Time is counted in ticks. The wheel has four levels of 64 slots; level
+ * L holds the timers expiring within 64^(L+1) ticks, in the slot given by
+ * bits 6L..6L+5 of their expiry tick. When the lower levels wrap around,
+ * the timers of the next slot of the level above are redistributed to
+ * lower levels (cascading), so scheduling and expiring a timer cost O(1)
+ * regardless of the number of outstanding timers. Timers further away
+ * than 64^4 ticks are parked in the top level and redistributed again.
+ *
+ * The wheel is not thread-safe; it is driven by a single thread.
+ */
+class TimerWheel {
+public:
+    using Tick = std::uint64_t;                 //!< Time in ticks
+    using Callback = std::function<void()>;     //!< Action of an expired timer
+
+private:
+    static constexpr unsigned int LevelBits = 6;
+    static constexpr unsigned int SlotCount = 1u << LevelBits;
+    static constexpr unsigned int SlotMask = SlotCount - 1;
+    static constexpr unsigned int LevelCount = 4;
+    static constexpr std::uint32_t NoTimer = ~std::uint32_t(0);
+
+    /*!
+     * \brief Timer kept in the pool, linked into the list of its slot.
+     */
+    struct Timer {
+        Tick Expiry;
+        Callback OnExpiry;
+        std::uint32_t Next;
+    };
+
+    std::vector<Timer> Pool;                        //!< Storage of all timers
+    std::vector<std::uint32_t> FreeTimers;          //!< Unused entries of the pool
+    std::uint32_t Slots[LevelCount][SlotCount];     //!< Heads of the slot lists
+    Tick Current = 0;                               //!< Last processed tick
+    std::size_t Count = 0;                          //!< Number of pending timers
+
+    /*!
+     * \brief Links a timer into the slot matching its expiry.
+     */
+    void Insert(std::uint32_t Index) {
+        const Tick span = Tick(1) << (LevelBits * LevelCount);
+        Tick expiry = Pool[Index].Expiry;
+        if (expiry - Current >= span) {
+            expiry = Current + span - 1;    // Parked, redistributed when its slot cascades
+        }
+
+        unsigned int level = 0;
+        while (level + 1 < LevelCount && expiry - Current >= (Tick(1) << (LevelBits * (level + 1)))) {
+            ++level;
+        }
+
+        std::uint32_t& head = Slots[level][(expiry >> (LevelBits * level)) & SlotMask];
+        Pool[Index].Next = head;
+        head = Index;
+    }
+
+    /*!
+     * \brief Moves the timers of one slot of an upper level to the lower levels.
+     */
+    void Cascade(unsigned int Level) {
+        std::uint32_t& head = Slots[Level][(Current >> (LevelBits * Level)) & SlotMask];
+        std::uint32_t index = head;
+        head = NoTimer;
+        while (index != NoTimer) {
+            const std::uint32_t next = Pool[index].Next;
+            Insert(index);
+            index = next;
+        }
+    }
+
+    /*!
+     * \brief Runs and releases the timers of the level 0 slot of the current tick.
+     */
+    void Expire() {
+        std::uint32_t index = Slots[0][Current & SlotMask];
+        Slots[0][Current & SlotMask] = NoTimer;
+        while (index != NoTimer) {
+            const std::uint32_t next = Pool[index].Next;
+            Callback onExpiry = std::move(Pool[index].OnExpiry);
+            Pool[index].OnExpiry = nullptr;
+            FreeTimers.push_back(index);
+            --Count;
+            if (onExpiry) onExpiry();   // May schedule new timers
+            index = next;
+        }
+    }
+
+public:
+    TimerWheel() {
+        for (auto& level : Slots) {
+            for (auto& head : level) head = NoTimer;
+        }
+    }
+
+    /*!
+     * \brief Schedules a timer.
+     *
+     * A timer expiring at or before the current tick fires at the next tick.
+     * \param Expiry Tick at which the timer expires.
+     * \param OnExpiry Action run by Advance() when the timer expires.
+     */
+    void Schedule(Tick Expiry, Callback OnExpiry) {
+        std::uint32_t index;
+        if (FreeTimers.empty()) {
+            index = static_cast<std::uint32_t>(Pool.size());
+            Pool.push_back(Timer{0, nullptr, NoTimer});
+        } else {
+            index = FreeTimers.back();
+            FreeTimers.pop_back();
+        }
+
+        Pool[index].Expiry = Expiry > Current ? Expiry : Current + 1;
+        Pool[index].OnExpiry = std::move(OnExpiry);
+        Insert(index);
+        ++Count;
+    }
+
+    /*!
+     * \brief Processes all ticks up to and including Now, running the expired timers.
+     */
+    void Advance(Tick Now) {
+        if (Count == 0) {   // Nothing to expire, skip the idle ticks
+            if (Now > Current) Current = Now;
+            return;
+        }
+
+        while (Current < Now && Count > 0) {
+            ++Current;
+            unsigned int level = 1;
+            while (level < LevelCount && (Current & ((Tick(1) << (LevelBits * level)) - 1)) == 0) {
+                ++level;
+            }
+            for (unsigned int upper = level - 1; upper >= 1; --upper) {
+                Cascade(upper);
+            }
+            Expire();
+        }
+        if (Now > Current) Current = Now;
+    }
+
+    /*!
+     * \brief Number of ticks after which Advance() may have work to do.
+     *
+     * This is a lower bound of the time to the next expiry: either the
+     * next non-empty level 0 slot or the next cascade of the upper levels.
+     * \pre The wheel is not empty.
+     */
+    Tick TicksToNextEvent() const {
+        const Tick toCascade = SlotCount - (Current & SlotMask);
+        for (Tick ticks = 1; ticks < toCascade; ++ticks) {
+            if (Slots[0][(Current + ticks) & SlotMask] != NoTimer) return ticks;
+        }
+        return toCascade;
+    }
+
+    /*!
+     * \brief Last processed tick.
+     */
+    Tick Now() const { return Current; }
+
+    /*!
+     * \brief Number of pending timers.
+     */
+    std::size_t Size() const { return Count; }
+
+    /*!
+     * \brief Tells whether there are no pending timers.
+     */
+    bool Empty() const { return Count == 0; }
+};
+
+#endif
@@ -0,0 +1,161 @@
+#ifndef TOKENCURSOR_HH
+#define TOKENCURSOR_HH
+
+#include <charconv>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include "SymbolTable.hh"
+
+/*!
+ * \class TokenCursor
+ * \brief Reads the whitespace-separated tokens of one script line without copying it.
+ *
+ * Used like an input stream: `rCursor >> Name >> Speed >> Length;` and
+ * then tested with `if (!rCursor)`. Numbers are parsed with
+ * std::from_chars and must span the whole token. A token naming a
+ * constant defined with `#define` is read as the constant's value, and a
+ * token such as `SPEED*2` as the value of the expression (see
+ * SymbolTable::Evaluate()), so constants never go through text.
+ *
+ * The cursor only refers to the text, which must outlive it.
+ */
+class TokenCursor {
+public:
+    using Constants = SymbolTable;      //!< Constants by name
+
+private:
+    std::string_view Rest;                      //!< Text not read yet
+    const Constants* pConstants;                //!< Constants substituted for numbers, may be nullptr
+    bool Failed = false;                        //!< A read failed, further reads are ignored
+
+    static bool IsSpace(char c) {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f';
+    }
+
+    /*!
+     * \brief Parses a whole token as a number.
+     */
+    template<typename Number>
+    static bool ParseNumber(std::string_view Token, Number& rValue) {
+        if (Token.size() > 1 && Token[0] == '+') Token.remove_prefix(1);   // Accepted by streams, not by from_chars
+        const auto result = std::from_chars(Token.data(), Token.data() + Token.size(), rValue);
+        return result.ec == std::errc() && result.ptr == Token.data() + Token.size();
+    }
+
+    /*!
+     * \brief Value of a token naming a constant or being an expression of constants.
+     * \return False if the token is neither.
+     */
+    bool EvaluateConstant(std::string_view Token, double& rValue) const {
+        if (!pConstants) return false;
+        if (const double* pValue = pConstants->Find(Token)) {
+            rValue = *pValue;
+            return true;
+        }
+        return pConstants->Evaluate(Token, rValue);
+    }
+
+public:
+    /*!
+     * \brief Creates a cursor at the beginning of the text.
+     * \param Text Tokens to read, usually the rest of a script line.
+     * \param pConsts Constants substituted for numeric tokens.
+     */
+    explicit TokenCursor(std::string_view Text, const Constants* pConsts = nullptr)
+        : Rest(Text), pConstants(pConsts) {}
+
+    /*!
+     * \brief Reads the next token.
+     * \return False if there are no more tokens.
+     */
+    bool Next(std::string_view& rToken) {
+        std::size_t begin = 0;
+        while (begin < Rest.size() && IsSpace(Rest[begin])) ++begin;
+        std::size_t end = begin;
+        while (end < Rest.size() && !IsSpace(Rest[end])) ++end;
+
+        rToken = Rest.substr(begin, end - begin);
+        Rest.remove_prefix(end);
+        return !rToken.empty();
+    }
+
+    /*!
+     * \brief Reads a token as a string.
+     */
+    TokenCursor& operator>>(std::string& rValue) {
+        std::string_view token;
+        if (Failed || !Next(token)) {
+            Failed = true;
+            return *this;
+        }
+        rValue.assign(token.data(), token.size());
+        return *this;
+    }
+
+    /*!
+     * \brief Reads a token as a number or the value of a constant.
+     */
+    template<typename Number, typename = std::enable_if_t<std::is_arithmetic<Number>::value>>
+    TokenCursor& operator>>(Number& rValue) {
+        std::string_view token;
+        if (Failed || !Next(token)) {
+            Failed = true;
+            return *this;
+        }
+
+        if (ParseNumber(token, rValue)) return *this;
+
+        double value;
+        if (EvaluateConstant(token, value)) {
+            rValue = static_cast<Number>(value);
+        } else {
+            Failed = true;
+        }
+        return *this;
+    }
+
+    /*!
+     * \brief Tells whether all reads succeeded.
+     */
+    explicit operator bool() const { return !Failed; }
+
+    /*!
+     * \brief Tells whether only whitespace is left.
+     */
+    bool AtEnd() const {
+        for (char c : Rest) {
+            if (!IsSpace(c)) return false;
+        }
+        return true;
+    }
+
+    /*!
+     * \brief Text not read yet.
+     */
+    std::string_view GetRest() const { return Rest; }
+
+    /*!
+     * \brief Reads all remaining tokens, with the constants replaced by their values.
+     * \return The tokens separated by single spaces.
+     */
+    std::string TakeRest() {
+        std::string text;
+        std::string_view token;
+        while (Next(token)) {
+            double value;
+            if (!ParseNumber(token, value) && EvaluateConstant(token, value)) {
+                char buffer[32];    // Shortest form which reads back as the same value
+                const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+                text.append(buffer, result.ptr);
+            } else {
+                text.append(token.data(), token.size());
+            }
+            text += ' ';
+        }
+        return text;
+    }
+};
+
+#endif
@@ -0,0 +1,145 @@
+#ifndef WORKERPOOL_HH
+#define WORKERPOOL_HH
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*!
+ * \class GroupBarrier
+ * \brief Completion barrier for a single group of commands.
+ *
+ * The barrier is armed with the number of tasks belonging to the group.
+ * Every task calls Arrive() once it is done, the thread that dispatched
+ * the group blocks in Wait() until all of them have arrived.
+ */
+class GroupBarrier {
+private:
+    std::mutex Mutex;              //!< Guards the pending counter
+    std::condition_variable Cond;  //!< Signalled when the counter drops to zero
+    std::size_t Pending;           //!< Number of tasks which have not arrived yet
+
+public:
+    /*!
+     * \brief Arms the barrier.
+     * \param Count Number of tasks which have to arrive.
+     */
+    explicit GroupBarrier(std::size_t Count) : Pending(Count) {}
+
+    /*!
+     * \brief Marks one task of the group as finished.
+     */
+    void Arrive() {
+        std::lock_guard<std::mutex> lock(Mutex);
+        if (Pending > 0 && --Pending == 0) {
+            Cond.notify_all();
+        }
+    }
+
+    /*!
+     * \brief Blocks until every task of the group has arrived.
+     */
+    void Wait() {
+        std::unique_lock<std::mutex> lock(Mutex);
+        Cond.wait(lock, [this]() { return Pending == 0; });
+    }
+};
+
+/*!
+ * \class WorkerPool
+ * \brief Fixed-size pool of persistent worker threads.
+ *
+ * Threads are started once and reused for every submitted task,
+ * so executing a command no longer costs a thread creation.
+ */
+class WorkerPool {
+private:
+    std::vector<std::thread> Workers;             //!< Persistent worker threads
+    std::deque<std::function<void()>> Tasks;      //!< Tasks waiting for a free worker
+    std::mutex Mutex;                             //!< Guards the task queue
+    std::condition_variable Cond;                 //!< Wakes up idle workers
+    bool Stopping;                                //!< Set when the pool is being destroyed
+
+    /*!
+     * \brief Main loop of a worker thread.
+     */
+    void WorkerLoop() {
+        for (;;) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(Mutex);
+                Cond.wait(lock, [this]() { return Stopping || !Tasks.empty(); });
+                if (Tasks.empty()) return;  // Stopping and nothing left to do
+
+                task = std::move(Tasks.front());
+                Tasks.pop_front();
+            }
+            task();
+        }
+    }
+
+public:
+    /*!
+     * \brief Starts the worker threads.
+     * \param ThreadCount Number of workers. When 0, the number of hardware
+     *                    threads is used (at least one worker is always started).
+     */
+    explicit WorkerPool(unsigned int ThreadCount = 0) : Stopping(false) {
+        if (ThreadCount == 0) {
+            ThreadCount = std::thread::hardware_concurrency();
+        }
+        if (ThreadCount == 0) {
+            ThreadCount = 1;
+        }
+
+        Workers.reserve(ThreadCount);
+        for (unsigned int i = 0; i < ThreadCount; ++i) {
+            Workers.emplace_back(&WorkerPool::WorkerLoop, this);
+        }
+    }
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    /*!
+     * \brief Finishes all queued tasks and joins the workers.
+     */
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(Mutex);
+            Stopping = true;
+        }
+        Cond.notify_all();
+
+        for (auto& worker : Workers) {
+            if (worker.joinable()) {
+                worker.join();
+            }
+        }
+    }
+
+    /*!
+     * \brief Queues a task for execution by one of the workers.
+     * \param Task The task to run.
+     */
+    void Submit(std::function<void()> Task) {
+        {
+            std::lock_guard<std::mutex> lock(Mutex);
+            Tasks.push_back(std::move(Task));
+        }
+        Cond.notify_one();
+    }
+
+    /*!
+     * \brief Returns the number of worker threads.
+     */
+    unsigned int GetThreadCount() const {
+        return static_cast<unsigned int>(Workers.size());
+    }
+};
+
+#endif
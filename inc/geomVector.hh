@@ -12,12 +12,11 @@
  */
 
 
-#ifdef __GNUG__
-#pragma interface
-#endif
 #include <iostream>
 #include <cmath>
 #include <cassert>
+#include <type_traits>
+#include <utility>
 
 
 /*!
@@ -52,15 +51,127 @@ namespace geom {
   inline
   int Sgn(double Val) { return Val > ERR_DOUBLE ? 1 : Val < -ERR_DOUBLE ? -1 : 0; }
   
+  namespace detail {
+
+   /*!
+    * \brief Wywołuje Fun(0), Fun(1), ..., Fun(Size-1).
+    *
+    * Pętla jest rozwijana w czasie kompilacji (wyrażenie fold), więc
+    * dla małych rozmiarów, np. 3 i 4, nie pozostaje po niej żaden licznik.
+    */
+   template<typename Fun, unsigned int... Ind>
+   constexpr void UnrollImpl(Fun &&Fun_, std::integer_sequence<unsigned int, Ind...>)
+   { (Fun_(Ind), ...); }
+
+   template<unsigned int Size, typename Fun>
+   constexpr void Unroll(Fun &&Fun_)
+   { UnrollImpl(Fun_, std::make_integer_sequence<unsigned int, Size>()); }
+
+   /*!
+    * \brief Sprawdza, czy Pred(0) && Pred(1) && ... && Pred(Size-1).
+    *
+    * Również rozwijana w czasie kompilacji; kończy się na pierwszym
+    * indeksie, dla którego Pred zwraca false.
+    */
+   template<typename Pred, unsigned int... Ind>
+   constexpr bool UnrollAllImpl(Pred &&Pred_, std::integer_sequence<unsigned int, Ind...>)
+   { return (Pred_(Ind) && ...); }
+
+   template<unsigned int Size, typename Pred>
+   constexpr bool UnrollAll(Pred &&Pred_)
+   { return UnrollAllImpl(Pred_, std::make_integer_sequence<unsigned int, Size>()); }
+
+  }
+
+
+/*!
+ * \brief Wyrażenie wektorowe (szablon wyrażeń).
+ *
+ * Klasa bazowa wektorów i wyrażeń zbudowanych z operatorów
+ * +, - oraz * i / przez liczbę. Wyrażenie nie tworzy obiektów
+ * pośrednich, jego składowe obliczane są dopiero przy przypisaniu
+ * do wektora, np. w \c a + b*s - c każda współrzędna wyniku liczona
+ * jest w jednym przebiegu.
+ *
+ * Wyrażenie przechowuje referencje do wektorów, z których powstało,
+ * dlatego należy je od razu przypisać do wektora, a nie przechowywać
+ * w zmiennej typu \c auto.
+ * \param Expr - typ wyrażenia (CRTP),
+ * \param Type - typ współrzędnej wektora,
+ * \param Size - rozmiar wektora.
+ */
+ template<typename Expr, typename Type, unsigned int Size>
+ struct VectorExpr {
+    /*!
+     * \brief Wartość wybranej współrzędnej wyrażenia.
+     */
+   constexpr Type operator [](unsigned int Ind) const
+     { return static_cast<const Expr&>(*this)[Ind]; }
+ };
+
+
+ template<typename Type, unsigned int Size> class Vector;
+
+  namespace detail {
+
+   /*!
+    * \brief Sposób przechowania argumentu w wyrażeniu.
+    *
+    * Wektory przechowywane są przez referencję, wyrażenia przez wartość.
+    */
+   template<typename Expr>
+   struct ExprRef { using type = Expr; };
+
+   template<typename Type, unsigned int Size>
+   struct ExprRef<Vector<Type,Size>> { using type = const Vector<Type,Size>&; };
+
+   /*!
+    * \brief Wyrażenie dwuargumentowe: suma lub różnica.
+    */
+   template<typename Left, typename Right, typename Op, typename Type, unsigned int Size>
+   class VectorBinary : public VectorExpr<VectorBinary<Left,Right,Op,Type,Size>,Type,Size> {
+     typename ExprRef<Left>::type   _Left;
+     typename ExprRef<Right>::type  _Right;
+    public:
+     constexpr VectorBinary(const Left &rLeft, const Right &rRight): _Left(rLeft), _Right(rRight) {}
+     constexpr Type operator [](unsigned int Ind) const { return Op::Apply(_Left[Ind],_Right[Ind]); }
+   };
+
+   /*!
+    * \brief Wyrażenie będące iloczynem wyrażenia i liczby.
+    */
+   template<typename Arg, typename Type, unsigned int Size>
+   class VectorScaled : public VectorExpr<VectorScaled<Arg,Type,Size>,Type,Size> {
+     typename ExprRef<Arg>::type  _Arg;
+     Type                         _Factor;
+    public:
+     constexpr VectorScaled(const Arg &rArg, Type Factor): _Arg(rArg), _Factor(Factor) {}
+     constexpr Type operator [](unsigned int Ind) const { return _Arg[Ind]*_Factor; }
+   };
+
+   /*!
+    * \brief Wyłącza dedukcję typu argumentu (liczby typu int przyjmowane są jak Type).
+    */
+   template<typename Type>
+   struct NoDeduce { using type = Type; };
+
+   struct OpAdd { template<typename Type> static constexpr Type Apply(Type x, Type y) { return x + y; } };
+   struct OpSub { template<typename Type> static constexpr Type Apply(Type x, Type y) { return x - y; } };
+
+  }
+
+
 /*!
  * \brief Model wektora N-wymiarowego
  *
- * Jest to szablon wektora N-wymiarowego.
+ * Jest to szablon wektora N-wymiarowego. Wszystkie operacje są
+ * constexpr, a pętle po współrzędnych rozwijane są w czasie kompilacji.
+ * Operatory arytmetyczne zwracają wyrażenia (zob. VectorExpr).
  * \param Type - typ współrzędnej wektora,
  * \param Size - rozmiar wektora.
  */
  template<typename Type, unsigned int Size>
- class Vector {
+ class Vector : public VectorExpr<Vector<Type,Size>,Type,Size> {
 
     /*!
      * \brief Tablica współrzędnych wektora
@@ -69,6 +180,13 @@ namespace geom {
      */
    Type  _Coord[Size];
 
+    /*!
+     * \brief Przypisuje współrzędnym wartości wyrażenia.
+     */
+   template<typename Expr>
+   constexpr void Assign(VectorExpr<Expr,Type,Size> const &rExpr)
+     { detail::Unroll<Size>([&](unsigned int Ind) { _Coord[Ind] = rExpr[Ind]; }); }
+
   public:
 
     /*!
@@ -76,18 +194,44 @@ namespace geom {
      *
      * Wszystkim współrzędnym przypisana jest wartość 0.
      */
-   Vector() { for (Type &Val : _Coord) Val = 0; }
+   constexpr Vector(): _Coord{} {}
+
+    /*!
+     * \brief Inicjalizuje wszystkie współrzędne wektora.
+     *
+     * Liczba argumentów musi być równa rozmiarowi wektora, np. Vector3D(1, 2, 3).
+     */
+   template<typename... Args,
+            typename = std::enable_if_t<sizeof...(Args) == Size &&
+                                        (std::is_arithmetic<Args>::value && ...)>>
+   constexpr Vector(Args... Coords): _Coord{static_cast<Type>(Coords)...} {}
+
+    /*!
+     * \brief Tworzy wektor o wartości wyrażenia.
+     */
+   template<typename Expr>
+   constexpr Vector(VectorExpr<Expr,Type,Size> const &rExpr): _Coord{}
+     { Assign(rExpr); }
+
+    /*!
+     * \brief Przypisuje wektorowi wartość wyrażenia.
+     */
+   template<typename Expr>
+   constexpr Vector<Type,Size> &operator = (VectorExpr<Expr,Type,Size> const &rExpr)
+     { Assign(rExpr); return *this; }
 
     /*!
      * \brief Dostęp do wybranej składowej wektora.
      *
      *  Dostęp do wybranej składowej wektora.
      *  Dostęp jest w trybie \e modyfikacji.
+     *  Zakres indeksu sprawdzany jest jedynie w wersji do debugowania
+     *  (bez NDEBUG); operacje na całym wektorze go nie sprawdzają.
      *  \param  Ind - indeks składowej wektora.
      *  \pre 0 <= Ind < Size.
      *  \post Referencja do żądanej składowej wektora.
      */
-   Type  &operator [](unsigned int Ind) { assert(Ind < Size); return _Coord[Ind]; }
+   constexpr Type  &operator [](unsigned int Ind) { assert(Ind < Size); return _Coord[Ind]; }
 
     /*!
      *  \brief Dostęp do wybranej składowej wektora.
@@ -98,62 +242,41 @@ namespace geom {
      *  \pre 0 <= Ind < Size.
      *  \post  Referencja do żądanej składowej wektora.
      */
-   Type operator [](unsigned int Ind) const { assert(Ind < Size); return _Coord[Ind]; }
-
+   constexpr Type operator [](unsigned int Ind) const { assert(Ind < Size); return _Coord[Ind]; }
 
-    /*! 
-     *  \brief Dostęp do wybranej składowej wektora.
-     *
-     *  Operacja implementuje sumę wektorów.
-     *  \param   rSkl2 - drugi składnik.
-     *  \retval  Vector<Type,Size> - obiekt zawierający wartość sumy
-     *                           dwóch wektorów \b *this i \e V.
+    /*!
+     * \brief Dostęp do tablicy współrzędnych.
      */
-    Vector<Type,Size>  operator  + (Vector<Type,Size> const &rSkl2) const;
+   constexpr Type *Data() { return _Coord; }
+   constexpr const Type *Data() const { return _Coord; }
+
 
-    /*! 
+    /*!
      *  \brief Dodaje wektora i przypisuje wynik sumy.
      *
-     *  Dodaje współrzędne wektora do wektora reprezentowanego przez obiekt,
-     *  dla którego ta opieracja zostałą wywołana.
+     *  Dodaje współrzędne wektora (lub wyrażenia) do wektora reprezentowanego
+     *  przez obiekt, dla którego ta opieracja zostałą wywołana.
      *  \param  rSkl2 - drugi argument operacji.
      *  \retval *this - referencja do pierwszego argumentu.
      */
-    Vector<Type,Size> &operator += (Vector<Type,Size> const &rSkl2);
+   template<typename Expr>
+   constexpr Vector<Type,Size> &operator += (VectorExpr<Expr,Type,Size> const &rSkl2)
+     { detail::Unroll<Size>([&](unsigned int Ind) { _Coord[Ind] += rSkl2[Ind]; }); return *this; }
 
-    /*! 
-     * \brief Różnica dwóch wektorów.
-     *
-     *  Operacja implementuje różnicę wektorów.
-     *  \param   rOdj - odjemnik.
-     *  \retval  Vector<Type,Size> - obiekt będący różnicą dwóch wektorów
-     *                                  \b *this i \e V.
-     */
-   Vector<Type,Size>  operator  - (Vector<Type,Size> const &rOdj) const;
-
-    /*! 
+    /*!
      * \brief Różnica dwóch wektorów i przypisanie wyniku.
      *
      *  Operacja implementuje różnicę wektorów i przypisanie wyniku
      *  operacji do odjemnej.
      *
-     *  \param  rOdj - odjemnik.
+     *  \param  rOdj - odjemnik (wektor lub wyrażenie).
      *  \retval *this - referencja do samego siebie.
-     *                  Obiekt przyjmuje nową wartość będącą 
+     *                  Obiekt przyjmuje nową wartość będącą
      *                 różnicą dwóch wektorów \b *this i \e V.
      */
-   Vector<Type,Size> &operator -= (Vector<Type,Size> const &rOdj);
-
-
-     /*!
-      * \brief Mnożenie wektora przez liczbę
-      *
-      * Operator implementuje mnożenie wektora przez liczbę.
-      * \param   Mnoznik - drugi czynnik iloczynu (liczba).
-      * \retval  Vector<Type,Size>  - obiekt będący  iloczynu wektora
-      *                            \b *this i liczby \e Mnoznik.
-      */
-   Vector<Type,Size>  operator  * (Type Mnoznik) const;
+   template<typename Expr>
+   constexpr Vector<Type,Size> &operator -= (VectorExpr<Expr,Type,Size> const &rOdj)
+     { detail::Unroll<Size>([&](unsigned int Ind) { _Coord[Ind] -= rOdj[Ind]; }); return *this; }
 
      /*!
       * \brief Mnożenie wektora przez liczbę i przypisanie wyniku
@@ -166,17 +289,8 @@ namespace geom {
       *              Obiekt przyjmuje nową wartość będącą
       *              produktem iloczynem \b *this i liczby \e Mnoznik.
       */
-   Vector<Type,Size> &operator *= (Type Mnoznik);
-
-     /*!
-      * \brief Dzielenie wektora przez liczbę
-      *
-      * Operator implementuje iloraz wektora przez liczbę.
-      * \param   Dzielnik - dzielnik wektora (liczba).
-      * \retval  Vector<Type,Size>  - obiekt będący ilorazem
-      *                            \b *this (wektor) / \e Dzielnik (liczba).
-      */
-   Vector<Type,Size>  operator  / (Type Dzielnik) const;
+   constexpr Vector<Type,Size> &operator *= (Type Mnoznik)
+     { detail::Unroll<Size>([&](unsigned int Ind) { _Coord[Ind] *= Mnoznik; }); return *this; }
 
      /*!
       * \brief Dzielenie wektora przez liczbę i przypisanie wyniku
@@ -188,17 +302,33 @@ namespace geom {
       *              Obiekt przyjmuje nową wartość będącą
       *              ilorazem \b *this i liczby \e Dzielnik.
       */
-   Vector<Type,Size> &operator /= (Type Dzielnik);
+   constexpr Vector<Type,Size> &operator /= (Type Dzielnik)
+     { detail::Unroll<Size>([&](unsigned int Ind) { _Coord[Ind] /= Dzielnik; }); return *this; }
+
+     /*!
+      * \brief Dodaje przeskalowany wektor (axpy).
+      *
+      * Realizuje \b *this += \e Mnoznik * \e rVec w jednym przebiegu,
+      * bez tworzenia obiektu pośredniego.
+      * \param Mnoznik - współczynnik skalujący,
+      * \param rVec - dodawany wektor (lub wyrażenie).
+      * \retval *this - referencję do samego siebie.
+      */
+   template<typename Expr>
+   constexpr Vector<Type,Size> &Axpy(Type Mnoznik, VectorExpr<Expr,Type,Size> const &rVec)
+     { detail::Unroll<Size>([&](unsigned int Ind) { _Coord[Ind] += Mnoznik*rVec[Ind]; }); return *this; }
 
      /*!
-      * \brief Iloczyn skalarny
+      * \brief Interpolacja liniowa w kierunku wektora docelowego.
       *
-      * Operator implementuje iloczyn skalarny dwóch wektorów.
-      * \param rVec - drugi czynnik iloczynu skalarnego.
-      * \return Wartość będącą iloczynem skalarnym wektorów \b *this
-      *         i \e rVec.
+      * Realizuje \b *this += \e t * (\e rTarget - \b *this) w jednym przebiegu.
+      * \param rTarget - wektor docelowy (osiągany dla \e t = 1),
+      * \param t - parametr interpolacji.
+      * \retval *this - referencję do samego siebie.
       */
-   Type  operator & (Vector<Type,Size> const &rVec) const;      // skalar product
+   template<typename Expr>
+   constexpr Vector<Type,Size> &Lerp(VectorExpr<Expr,Type,Size> const &rTarget, Type t)
+     { detail::Unroll<Size>([&](unsigned int Ind) { _Coord[Ind] += t*(rTarget[Ind] - _Coord[Ind]); }); return *this; }
 
 
     /*!
@@ -212,7 +342,7 @@ namespace geom {
      *              obliczeń,
      *  \retval  false - w przypadku przeciwnym.
      */
-   bool          operator == (Vector<Type,Size> const &rArg2);
+   bool          operator == (Vector<Type,Size> const &rArg2) const;
 
 
 
@@ -230,7 +360,8 @@ namespace geom {
      *  Zmienia znak wszystkich składowych wektora na przeciwny.
      *  \return\b *this - zwraca referencję do samego siebie.
      */
-    Vector<Type,Size> &Inverse() { for (Type &Crd : _Coord ) Crd = -Crd; return *this; }
+    constexpr Vector<Type,Size> &Inverse()
+      { detail::Unroll<Size>([&](unsigned int Ind) { _Coord[Ind] = -_Coord[Ind]; }); return *this; }
 
 
 
@@ -239,7 +370,7 @@ namespace geom {
      *
      *  Wszystkim współrzędnym wektora przypisana zostaj wartość 0.
      */
-    void SetZero() { for (Type &Crd : _Coord ) Crd = 0;  }
+    constexpr void SetZero() { detail::Unroll<Size>([&](unsigned int Ind) { _Coord[Ind] = 0; }); }
 
 
     /*!
@@ -252,7 +383,8 @@ namespace geom {
      * \return true - jeśli sgn zwróci dla wszystkich pól zero,
      * \return false - w przypadku przeciwnym.
      */
-    bool IsZero() const  { for (Type Crd : _Coord ) if (Crd) return false;  return true; }
+    constexpr bool IsZero() const
+      { return detail::UnrollAll<Size>([&](unsigned int Ind) { return !_Coord[Ind]; }); }
 
 
     /*!
@@ -266,7 +398,7 @@ namespace geom {
      *               (\e x_min, \e x_max).
      * \return false - w przypadku przeciwnym.
      */
-   bool IsInside(unsigned int Ind, Type x_min, Type x_max) const
+   constexpr bool IsInside(unsigned int Ind, Type x_min, Type x_max) const
      { return (x_min < _Coord[Ind]) && (_Coord[Ind] < x_max);}
 
     /*!
@@ -275,138 +407,154 @@ namespace geom {
      * Zakłada się, że ścianki prostopadłościanu są równoległe do jednej
      * z płaszczyzn kartezjańskiego układu współrzędnych OXY.
      * \param Min - zawiera współrzędne wierzchołka, którego składowe
-     *              mają minimalne wartości spośród składowych tego 
+     *              mają minimalne wartości spośród składowych tego
      *              samego typu wszystkich wierzchołków
      *              tego prostopadłościanu.
      * \param Max - zawiera współrzędne wierzchołka, którego składowe
-     *              mają maksymalne wartości spośród składowych tego 
+     *              mają maksymalne wartości spośród składowych tego
      *              samego typu wszystkich wierzchołków
      *              tego prostopadłościanu.
      *              prostopadłościanu.
      * \return  true  - jeśli punkt jest wewnątrz prostopadłościanu.
      * \return  false - w przypadku przeciwnym.
      */
-   bool IsInside(Vector<Type,Size> const &Min, Vector<Type,Size> Max) const;
+   constexpr bool IsInside(Vector<Type,Size> const &Min, Vector<Type,Size> const &Max) const;
 
     /*!
      * \brief Normalizuje wektor
      *
-     * Metoda normalizuje wektor.
+     * Metoda normalizuje wektor w miejscu (jedno dzielenie, mnożenia
+     * przez odwrotność długości). Wektor zerowy pozostaje bez zmian.
      * Po tej operacji długość wektora bardzo bliska wartości 1.
      * Ewentualne odchyłki są związane z błędami obliczeń
      * będących następstwem skończonej reprezentacji liczb rzeczywistych.
+     * \retval *this - referencję do samego siebie.
      */
-   void Normalize() 
-     { Type d = Length(); for (Type &Crd : _Coord) Crd /= d; }
+   Vector<Type,Size> &Normalize()
+     { Type d = Length(); if (d != 0) *this *= Type(1)/d; return *this; }
  };
 
- 
- template<typename Type, unsigned int Size>
- inline
- bool Vector<Type,Size>::IsInside(Vector<Type,Size> const &Min, Vector<Type,Size> Max) const
- {
-   for (unsigned Ind = 0; Ind < Size; ++Ind) {
-     if (!IsInside(Ind,Min[Ind],Max[Ind])) return false;
-   }
-   return true;
- }
 
-
-
- template<typename Type, unsigned int Size>
- inline
- Type Vector<Type,Size>::Length() const
+ /*!
+  * \brief Suma dwóch wektorów (wyrażeń).
+  *
+  *  Operacja implementuje sumę wektorów.
+  *  \retval Wyrażenie, którego współrzędne są sumami współrzędnych argumentów.
+  */
+ template<typename Left, typename Right, typename Type, unsigned int Size>
+ constexpr
+ detail::VectorBinary<Left,Right,detail::OpAdd,Type,Size>
+ operator + (VectorExpr<Left,Type,Size> const &rSkl1, VectorExpr<Right,Type,Size> const &rSkl2)
  {
-   return sqrt(*this & *this);
+   return {static_cast<const Left&>(rSkl1), static_cast<const Right&>(rSkl2)};
  }
 
 
- template<typename Type, unsigned int Size>
- inline
- Vector<Type,Size> &Vector<Type,Size>::operator += (Vector<Type,Size> const &rSkl2)
+ /*!
+  * \brief Różnica dwóch wektorów (wyrażeń).
+  *
+  *  Operacja implementuje różnicę wektorów.
+  *  \retval Wyrażenie, którego współrzędne są różnicami współrzędnych argumentów.
+  */
+ template<typename Left, typename Right, typename Type, unsigned int Size>
+ constexpr
+ detail::VectorBinary<Left,Right,detail::OpSub,Type,Size>
+ operator - (VectorExpr<Left,Type,Size> const &rOdjemna, VectorExpr<Right,Type,Size> const &rOdj)
  {
-   for (unsigned int Ind = 0; Ind < Size; ++Ind) _Coord[Ind] += rSkl2[Ind];
-   return *this;
+   return {static_cast<const Left&>(rOdjemna), static_cast<const Right&>(rOdj)};
  }
-  
 
- template<typename Type, unsigned int Size>
- inline
- Vector<Type,Size> Vector<Type,Size>::operator + (Vector const &rSkl2) const
+
+ /*!
+  * \brief Mnożenie wektora (wyrażenia) przez liczbę.
+  */
+ template<typename Arg, typename Type, unsigned int Size>
+ constexpr
+ detail::VectorScaled<Arg,Type,Size>
+ operator * (VectorExpr<Arg,Type,Size> const &rVec, typename detail::NoDeduce<Type>::type Mnoznik)
  {
-   return Vector<Type,Size>(*this) += rSkl2;
+   return {static_cast<const Arg&>(rVec), Mnoznik};
  }
 
 
- template<typename Type, unsigned int Size>
- inline
- Vector<Type,Size> &Vector<Type,Size>::operator -= (Vector<Type,Size> const & rOdj)
+ /*!
+  * \brief Mnożenie liczby przez wektor (wyrażenie).
+  */
+ template<typename Arg, typename Type, unsigned int Size>
+ constexpr
+ detail::VectorScaled<Arg,Type,Size>
+ operator * (typename detail::NoDeduce<Type>::type Mnoznik, VectorExpr<Arg,Type,Size> const &rVec)
  {
-   for (unsigned int Ind = 0; Ind < Size; ++Ind) _Coord[Ind] -= rOdj[Ind];
-   return *this;
+   return {static_cast<const Arg&>(rVec), Mnoznik};
  }
 
 
- template<typename Type, unsigned int Size>
- inline
- Vector<Type,Size> Vector<Type,Size>::operator - (Vector<Type,Size>  const &rOdj) const
+ /*!
+  * \brief Dzielenie wektora (wyrażenia) przez liczbę.
+  */
+ template<typename Arg, typename Type, unsigned int Size>
+ constexpr
+ detail::VectorScaled<Arg,Type,Size>
+ operator / (VectorExpr<Arg,Type,Size> const &rVec, typename detail::NoDeduce<Type>::type Dzielnik)
  {
-   return Vector<Type,Size>(*this) -= rOdj;
+   return {static_cast<const Arg&>(rVec), Type(1)/Dzielnik};
  }
 
 
- template<typename Type, unsigned int Size>
- inline
- Vector<Type,Size> &Vector<Type,Size>::operator *= (Type Mnoznik)
+ /*!
+  * \brief Iloczyn skalarny
+  *
+  * Operator implementuje iloczyn skalarny dwóch wektorów (wyrażeń).
+  * \return Wartość będącą iloczynem skalarnym argumentów.
+  */
+ template<typename Left, typename Right, typename Type, unsigned int Size>
+ constexpr
+ Type operator & (VectorExpr<Left,Type,Size> const &rVec1, VectorExpr<Right,Type,Size> const &rVec2)
  {
-   for (Type Crd : _Coord ) Crd *= Mnoznik;
-   return *this;
+   Type Res = 0;
+   detail::Unroll<Size>([&](unsigned int Ind) { Res += rVec1[Ind] * rVec2[Ind]; });
+   return Res;
  }
 
 
+ /*!
+  * \brief Interpolacja liniowa między dwoma wektorami.
+  *
+  * \param rFrom - wektor dla \e t = 0,
+  * \param rTo - wektor dla \e t = 1,
+  * \param t - parametr interpolacji.
+  * \return Wektor \e rFrom + \e t * (\e rTo - \e rFrom).
+  */
  template<typename Type, unsigned int Size>
- inline
- Vector<Type,Size> Vector<Type,Size>::operator * (Type Mnoznik) const
+ constexpr
+ Vector<Type,Size> Lerp(Vector<Type,Size> const &rFrom, Vector<Type,Size> const &rTo, typename detail::NoDeduce<Type>::type t)
  {
-   return Vector<Type,Size>(*this) *= Mnoznik;  
+   return Vector<Type,Size>(rFrom).Lerp(rTo, t);
  }
 
 
-
  template<typename Type, unsigned int Size>
- inline
- Vector<Type,Size> &Vector<Type,Size>::operator /= (Type Digit)
+ constexpr
+ bool Vector<Type,Size>::IsInside(Vector<Type,Size> const &Min, Vector<Type,Size> const &Max) const
  {
-   for (Type Crd : _Coord ) Crd /= Digit;
-   return *this;
+   return detail::UnrollAll<Size>([&](unsigned int Ind) { return IsInside(Ind,Min[Ind],Max[Ind]); });
  }
-  
 
- template<typename Type, unsigned int Size>
- inline
- Vector<Type,Size> Vector<Type,Size>::operator / (Type Dzielnik) const
- {
-   return Vector<Type,Size>(*this) /= Dzielnik;    
- }
 
 
  template<typename Type, unsigned int Size>
  inline
- bool Vector<Type,Size>::operator == (Vector<Type,Size> const &rArg2)
+ Type Vector<Type,Size>::Length() const
  {
-   for (unsigned int Idx = 0; Idx < Size; ++Idx)
-             if (Sgn(_Coord[Idx]-rArg2[Idx]) != 0) return false;
-   return true;
+   return sqrt(*this & *this);
  }
 
 
  template<typename Type, unsigned int Size>
  inline
- Type Vector<Type,Size>::operator & (Vector<Type,Size> const &rVec) const
+ bool Vector<Type,Size>::operator == (Vector<Type,Size> const &rArg2) const
  {
-   Type Res = 0;
-   for (unsigned int Idx = 0; Idx < Size; ++Idx) Res += _Coord[Idx] * rVec[Idx];  
-   return Res;
+   return detail::UnrollAll<Size>([&](unsigned int Ind) { return Sgn(_Coord[Ind]-rArg2[Ind]) == 0; });
  }
 
 }
@@ -72,7 +72,7 @@ class XMLInterp4Config : public xercesc::DefaultHandler {
     /*!
      * \brief Wykonuje operacje związane z danym elementem XML
      */
-    void WhenStartElement( const std::string&             rElemName,
+    void WhenStartElement( const XMLCh                   *pElemName,
 		           const xercesc::Attributes&     rAttrs
                          );
     /*!
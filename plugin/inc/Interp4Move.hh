@@ -31,15 +31,20 @@ class Interp4Move: public AbstractInterp4Command {
   double Speed_mmS;
   double Length;
 
+  AbstractMobileObj *pObj;   // Przesuwany obiekt, wyznaczony przez BindObjects()
+  std::mutex *pObjMutex;     // Mutex chroniący stan przesuwanego obiektu
+  Vector3D Direction;        // Wektor jednostkowy kierunku ruchu, wyznaczany raz na początku ruchu
+  double Distance_done;      // Droga, którą obiekt już przebył [m]
+
   public:
   /*!
    * \brief
    */
   Interp4Move();  
   /*!
-   * \brief Wyświetla postać bieżącego polecenia (nazwę oraz wartości parametrów)
+   * \brief Wypisuje postać bieżącego polecenia (nazwę oraz wartości parametrów)
    */
-  virtual void PrintCmd() const override;
+  virtual void PrintCmd(std::ostream &rOut) const override;
   /*!
    * \brief Wyświetla składnię polecenia
    */
@@ -71,6 +76,38 @@ class Interp4Move: public AbstractInterp4Command {
    * \brief Czyta wartości parametrów danego polecenia
    */
   virtual bool ReadParams(std::istream& Strm_CmdsList) override;
+  /*!
+   * \brief Czyta wartości parametrów danego polecenia bezpośrednio z wiersza skryptu
+   */
+  virtual bool ReadParams(TokenCursor& rCursor) override;
+  /*!
+   * \brief Zapisuje parametry polecenia w postaci binarnej
+   */
+  virtual bool SaveParams(std::string& rBuffer) const override;
+  /*!
+   * \brief Odtwarza parametry zapisane przez SaveParams()
+   */
+  virtual bool LoadParams(std::string_view& rData) override;
+  /*!
+   * \brief Wyszukuje przesuwany obiekt i zapamiętuje jego uchwyt
+   */
+  virtual bool BindObjects(AbstractScene &rScn) override;
+
+  /*!
+   * \brief Polecenie jest animacją krokowaną przez zegar ramek
+   */
+  virtual bool IsAnimation() const override { return true; }
+  /*!
+   * \brief Sprawdza parametry i wyznacza kierunek ruchu z bieżących kątów obiektu
+   */
+  virtual bool StartAnimation( AbstractScene      &rScn,
+                               AbstractComChannel &rComChann ) override;
+  /*!
+   * \brief Przesuwa obiekt o drogę odpowiadającą czasowi Dt_s
+   */
+  virtual bool Advance( double              Dt_s,
+                        AbstractScene      &rScn,
+                        AbstractComChannel &rComChann ) override;
 
   
   /*!
@@ -34,9 +34,9 @@ class Interp4Pause: public AbstractInterp4Command {
    */
   Interp4Pause();  
   /*!
-   * \brief Wyświetla postać bieżącego polecenia (nazwę oraz wartości parametrów)
+   * \brief Wypisuje postać bieżącego polecenia (nazwę oraz wartości parametrów)
    */
-  virtual void PrintCmd() const override;
+  virtual void PrintCmd(std::ostream &rOut) const override;
   /*!
    * \brief Wyświetla składnię polecenia
    */
@@ -68,6 +68,27 @@ class Interp4Pause: public AbstractInterp4Command {
    * \brief Czyta wartości parametrów danego polecenia
    */
   virtual bool ReadParams(std::istream& Strm_CmdsList) override;
+  /*!
+   * \brief Czyta wartości parametrów danego polecenia bezpośrednio z wiersza skryptu
+   */
+  virtual bool ReadParams(TokenCursor& rCursor) override;
+  /*!
+   * \brief Zapisuje parametry polecenia w postaci binarnej
+   */
+  virtual bool SaveParams(std::string& rBuffer) const override;
+  /*!
+   * \brief Odtwarza parametry zapisane przez SaveParams()
+   */
+  virtual bool LoadParams(std::string_view& rData) override;
+
+  /*!
+   * \brief Polecenie jest odczekaniem, realizowanym przez koło zegarowe interpretera
+   */
+  virtual bool IsDelay() const override { return true; }
+  /*!
+   * \brief Udostępnia czas pauzy
+   */
+  virtual double GetDelay_ms() const override { return Time_ms; }
 
   
   /*!
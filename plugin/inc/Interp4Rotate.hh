@@ -36,15 +36,20 @@ class Interp4Rotate: public AbstractInterp4Command {
   double Angle_speed;
   double Angle;
 
+  AbstractMobileObj *pObj;   // Obiekt obracany przez trwającą animację
+  std::mutex *pObjMutex;     // Mutex chroniący stan obracanego obiektu
+  int Axis_idx;              // Indeks osi obrotu: 0 - OX, 1 - OY, 2 - OZ
+  double Angle_done;         // Kąt, o który obiekt został już obrócony
+
   public:
   /*!
    * \brief
    */
   Interp4Rotate();  
   /*!
-   * \brief Wyświetla postać bieżącego polecenia (nazwę oraz wartości parametrów)
+   * \brief Wypisuje postać bieżącego polecenia (nazwę oraz wartości parametrów)
    */
-  virtual void PrintCmd() const override;
+  virtual void PrintCmd(std::ostream &rOut) const override;
   /*!
    * \brief Wyświetla składnię polecenia
    */
@@ -76,6 +81,39 @@ class Interp4Rotate: public AbstractInterp4Command {
    * \brief Czyta wartości parametrów danego polecenia
    */
   virtual bool ReadParams(std::istream& Strm_CmdsList) override;
+  /*!
+   * \brief Czyta wartości parametrów danego polecenia bezpośrednio z wiersza skryptu
+   */
+  virtual bool ReadParams(TokenCursor& rCursor) override;
+  /*!
+   * \brief Zapisuje parametry polecenia w postaci binarnej
+   */
+  virtual bool SaveParams(std::string& rBuffer) const override;
+  /*!
+   * \brief Odtwarza parametry zapisane przez SaveParams()
+   */
+  virtual bool LoadParams(std::string_view& rData) override;
+
+  /*!
+   * \brief Wyszukuje obracany obiekt i zapamiętuje jego uchwyt
+   */
+  virtual bool BindObjects(AbstractScene &rScn) override;
+
+  /*!
+   * \brief Polecenie jest animacją krokowaną przez zegar ramek
+   */
+  virtual bool IsAnimation() const override { return true; }
+  /*!
+   * \brief Sprawdza parametry i zeruje postęp obrotu
+   */
+  virtual bool StartAnimation( AbstractScene      &rScn,
+                               AbstractComChannel &rComChann ) override;
+  /*!
+   * \brief Obraca obiekt o kąt odpowiadający czasowi Dt_s
+   */
+  virtual bool Advance( double              Dt_s,
+                        AbstractScene      &rScn,
+                        AbstractComChannel &rComChann ) override;
 
   
   /*!
@@ -22,16 +22,21 @@ class Interp4Set: public AbstractInterp4Command {
   double Angle_X, Angle_Y, Angle_Z;               // Rotation angles
   double Scale_X, Scale_Y, Scale_Z;               // Scale factors
   int Color_R, Color_G, Color_B;                  // RGB color values
+  AbstractMobileObj* pObj;                        // Object bound by BindObjects()
 
 public:
   Interp4Set();  
 
-  virtual void PrintCmd() const override;
+  virtual void PrintCmd(std::ostream &rOut) const override;
   virtual void PrintSyntax() const override;
   virtual void PrintParams() const override {}
   virtual const char* GetCmdName() const override;
   virtual bool ExecCmd(AbstractScene &rScn, const char *sMobObjName, AbstractComChannel &rComChann) override;
   virtual bool ReadParams(std::istream& Strm_CmdsList) override;
+  virtual bool ReadParams(TokenCursor& rCursor) override;
+  virtual bool SaveParams(std::string& rBuffer) const override;
+  virtual bool LoadParams(std::string_view& rData) override;
+  virtual bool BindObjects(AbstractScene &rScn) override;
 
   static AbstractInterp4Command* CreateCmd();
 };
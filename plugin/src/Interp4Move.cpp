@@ -1,5 +1,10 @@
 #include <iostream>
+#include <algorithm>
+#include <cmath>
 #include "Interp4Move.hh"
+#include "CommandArena.hh"
+#include "ProgramCache.hh"
+#include "Logger.hh"
 
 
 using std::cout;
@@ -8,6 +13,7 @@ using std::endl;
 
 extern "C" {
   AbstractInterp4Command* CreateCmd(void);
+  AbstractInterp4Command* CreateCmdIn(CommandArena &rArena);
   const char* GetCmdName() { return "Move"; }
 }
 
@@ -25,19 +31,28 @@ AbstractInterp4Command* CreateCmd(void)
 }
 
 
+/*!
+ * \brief Tworzy polecenie w pamięci areny skryptu
+ */
+AbstractInterp4Command* CreateCmdIn(CommandArena &rArena)
+{
+  return rArena.Create<Interp4Move>();
+}
+
+
 /*!
  *
  */
-Interp4Move::Interp4Move(): Speed_mmS(0), Length(0)
+Interp4Move::Interp4Move(): Speed_mmS(0), Length(0), pObj(nullptr), pObjMutex(nullptr), Distance_done(0)
 {}
 
 
 /*!
  *
  */
-void Interp4Move::PrintCmd() const
+void Interp4Move::PrintCmd(std::ostream &rOut) const
 {
-  cout << GetCmdName() << ": " << Object_name << " " << Speed_mmS  << " " << Length << endl;
+  rOut << GetCmdName() << ": " << Object_name << " " << Speed_mmS  << " " << Length;
 }
 
 
@@ -58,10 +73,61 @@ bool Interp4Move::ExecCmd( AbstractScene      &rScn,
 			   AbstractComChannel &rComChann
 			 )
 {
-  /*
-   *  Tu trzeba napisać odpowiedni kod.
-   */
-  return true;
+    LOG_DEBUG("ExecCmd Interp4Move for " << Object_name);
+    return RunAnimationStandalone(rScn, rComChann);
+}
+
+
+/*!
+ *
+ */
+bool Interp4Move::StartAnimation(AbstractScene &rScn, AbstractComChannel &rComChann)
+{
+    if (!pObj && !BindObjects(rScn)) {   // Not bound while loading
+        return false;
+    }
+
+    if (Speed_mmS <= 0) {
+        LOG_ERROR("Invalid speed: " << Speed_mmS);
+        return false;
+    }
+
+    // The heading is the x axis of the object, i.e. the first column of Rz(yaw) * Ry(pitch).
+    // It is computed once, the steps only scale it.
+    double pitch, yaw;
+    {
+        std::lock_guard<std::mutex> lock(*pObjMutex);
+        pitch = pObj->GetAng_Pitch_deg() * M_PI / 180.0;
+        yaw = pObj->GetAng_Yaw_deg() * M_PI / 180.0;
+    }
+    const double sign = Length < 0 ? -1.0 : 1.0;    // Negative length moves backwards
+    Direction = Vector3D(sign * std::cos(yaw) * std::cos(pitch),
+                         sign * std::sin(yaw) * std::cos(pitch),
+                         -sign * std::sin(pitch));
+
+    Distance_done = 0;
+    return true;
+}
+
+
+/*!
+ *
+ */
+bool Interp4Move::Advance(double Dt_s, AbstractScene &rScn, AbstractComChannel &rComChann)
+{
+    const double remaining = std::fabs(Length) - Distance_done;
+    const double step = std::min(Speed_mmS * Dt_s, remaining);
+    Distance_done += step;
+
+    {
+        std::lock_guard<std::mutex> lock(*pObjMutex);   // Only this object is locked
+        Vector3D position = pObj->GetPositoin_m();
+        position.Axpy(step, Direction);
+        pObj->SetPosition_m(position);
+    }
+    // The scene sends the new position at the end of the frame.
+
+    return Distance_done < std::fabs(Length);
 }
 
 
@@ -76,6 +142,54 @@ bool Interp4Move::ReadParams(std::istream& Strm_CmdsList)
 }
 
 
+/*!
+ *
+ */
+bool Interp4Move::ReadParams(TokenCursor& rCursor)
+{
+  rCursor >> Object_name >> Speed_mmS >> Length;
+  return static_cast<bool>(rCursor);
+}
+
+
+/*!
+ *
+ */
+bool Interp4Move::SaveParams(std::string& rBuffer) const
+{
+  progcache::PutString(rBuffer, Object_name);
+  progcache::Put(rBuffer, Speed_mmS);
+  progcache::Put(rBuffer, Length);
+  return true;
+}
+
+
+/*!
+ *
+ */
+bool Interp4Move::LoadParams(std::string_view& rData)
+{
+  return progcache::GetString(rData, Object_name)
+      && progcache::Get(rData, Speed_mmS)
+      && progcache::Get(rData, Length);
+}
+
+
+/*!
+ *
+ */
+bool Interp4Move::BindObjects(AbstractScene &rScn)
+{
+  pObj = rScn.FindMobileObj(Object_name.c_str());
+  if (!pObj) {
+    LOG_ERROR("Object not found: " << Object_name);
+    return false;
+  }
+  pObjMutex = &rScn.GetObjMutex(pObj);
+  return true;
+}
+
+
 /*!
  *
  */
@@ -90,5 +204,5 @@ AbstractInterp4Command* Interp4Move::CreateCmd()
  */
 void Interp4Move::PrintSyntax() const
 {
-  cout << "   Move  NazwaObiektu  Szybkosc[m/s]  DlugoscDrogi[m]" << endl;
+  LOG_INFO("   Move  NazwaObiektu  Szybkosc[m/s]  DlugoscDrogi[m]");
 }
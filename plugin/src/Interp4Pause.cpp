@@ -1,5 +1,10 @@
 #include <iostream>
+#include <chrono>
+#include <thread>
 #include "Interp4Pause.hh"
+#include "CommandArena.hh"
+#include "ProgramCache.hh"
+#include "Logger.hh"
 
 
 using std::cout;
@@ -8,6 +13,7 @@ using std::endl;
 
 extern "C" {
   AbstractInterp4Command* CreateCmd(void);
+  AbstractInterp4Command* CreateCmdIn(CommandArena &rArena);
   const char* GetCmdName() { return "Pause"; }
 }
 
@@ -25,6 +31,15 @@ AbstractInterp4Command* CreateCmd(void)
 }
 
 
+/*!
+ * \brief Tworzy polecenie w pamięci areny skryptu
+ */
+AbstractInterp4Command* CreateCmdIn(CommandArena &rArena)
+{
+  return rArena.Create<Interp4Pause>();
+}
+
+
 /*!
  *
  */
@@ -35,9 +50,9 @@ Interp4Pause::Interp4Pause(): Time_ms(0)
 /*!
  *
  */
-void Interp4Pause::PrintCmd() const
+void Interp4Pause::PrintCmd(std::ostream &rOut) const
 {
-  cout << GetCmdName() << ": " << Time_ms << endl;
+  rOut << GetCmdName() << ": " << Time_ms;
 }
 
 
@@ -55,9 +70,10 @@ const char* Interp4Pause::GetCmdName() const
  */
 bool Interp4Pause::ExecCmd(AbstractScene &rScn, const char *sMobObjName, AbstractComChannel &rComChann)
 {
-  /*
-   *  Tu trzeba napisać odpowiedni kod.
-   */
+  // The interpreter waits on its timer wheel instead (see IsDelay()); this is for direct callers only.
+  if (Time_ms > 0) {
+    std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(Time_ms));
+  }
   return true;
 }
 
@@ -72,6 +88,35 @@ bool Interp4Pause::ReadParams(std::istream& Strm_CmdsList)
 }
 
 
+/*!
+ *
+ */
+bool Interp4Pause::ReadParams(TokenCursor& rCursor)
+{
+  rCursor >> Time_ms;
+  return static_cast<bool>(rCursor);
+}
+
+
+/*!
+ *
+ */
+bool Interp4Pause::SaveParams(std::string& rBuffer) const
+{
+  progcache::Put(rBuffer, Time_ms);
+  return true;
+}
+
+
+/*!
+ *
+ */
+bool Interp4Pause::LoadParams(std::string_view& rData)
+{
+  return progcache::Get(rData, Time_ms);
+}
+
+
 /*!
  *
  */
@@ -86,5 +131,5 @@ AbstractInterp4Command* Interp4Pause::CreateCmd()
  */
 void Interp4Pause::PrintSyntax() const
 {
-  cout << "   Pause CzasPausy[ms]" << endl;
+  LOG_INFO("   Pause CzasPausy[ms]");
 }
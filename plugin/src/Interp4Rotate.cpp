@@ -1,5 +1,10 @@
 #include <iostream>
+#include <algorithm>
+#include <cmath>
 #include "Interp4Rotate.hh"
+#include "CommandArena.hh"
+#include "ProgramCache.hh"
+#include "Logger.hh"
 
 
 using std::cout;
@@ -8,6 +13,7 @@ using std::endl;
 
 extern "C" {
   AbstractInterp4Command* CreateCmd(void);
+  AbstractInterp4Command* CreateCmdIn(CommandArena &rArena);
   const char* GetCmdName() { return "Rotate"; }
 }
 
@@ -25,20 +31,30 @@ AbstractInterp4Command* CreateCmd(void)
 }
 
 
+/*!
+ * \brief Tworzy polecenie w pamięci areny skryptu
+ */
+AbstractInterp4Command* CreateCmdIn(CommandArena &rArena)
+{
+  return rArena.Create<Interp4Rotate>();
+}
+
+
 /*!
  *
  */
-Interp4Rotate::Interp4Rotate(): Axis_name("OZ"), Angle_speed(0), Angle(0)
+Interp4Rotate::Interp4Rotate(): Axis_name("OZ"), Angle_speed(0), Angle(0),
+                                pObj(nullptr), pObjMutex(nullptr), Axis_idx(2), Angle_done(0)
 {}
 
 
 /*!
  *
  */
-void Interp4Rotate::PrintCmd() const
+void Interp4Rotate::PrintCmd(std::ostream &rOut) const
 {
-  cout << GetCmdName() << ": " << Object_name << " " << Axis_name << " "
-       << Angle_speed << " " << Angle << endl;
+  rOut << GetCmdName() << ": " << Object_name << " " << Axis_name << " "
+       << Angle_speed << " " << Angle;
 }
 
 
@@ -55,58 +71,75 @@ const char* Interp4Rotate::GetCmdName() const
  *
  */
 bool Interp4Rotate::ExecCmd(AbstractScene &rScn, const char *sMobObjName, AbstractComChannel &rComChann) {
-    std::cout << "ExecCmd Interp4Rotate for rotation" << std::endl;
+    LOG_DEBUG("ExecCmd Interp4Rotate for rotation");
+    return RunAnimationStandalone(rScn, rComChann);
+}
 
-    AbstractMobileObj* obj = rScn.FindMobileObj(Object_name.c_str());
-    if (!obj) {
-        std::cerr << "Object not found: " << sMobObjName << std::endl;
+
+/*!
+ *
+ */
+bool Interp4Rotate::BindObjects(AbstractScene &rScn) {
+    pObj = rScn.FindMobileObj(Object_name.c_str());
+    if (!pObj) {
+        LOG_ERROR("Object not found: " << Object_name);
         return false;
     }
+    pObjMutex = &rScn.GetObjMutex(pObj);
+    return true;
+}
 
-    const int fps = 30;
-    const double frameTimeMs = 1000.0 / fps;
-
-    double durationMs = (Angle / Angle_speed) * 1000.0;
-    int totalFrames = static_cast<int>(std::ceil(durationMs / frameTimeMs));
 
-    double stepAngle = Angle / totalFrames;
+/*!
+ *
+ */
+bool Interp4Rotate::StartAnimation(AbstractScene &rScn, AbstractComChannel &rComChann) {
+    if (!pObj && !BindObjects(rScn)) {   // Not bound while loading
+        return false;
+    }
 
-    for (int frame = 0; frame < totalFrames; ++frame) {
-        {
-            std::lock_guard<std::mutex> lock(rScn.GetMutex());
+    if (Axis_name == "OX") {
+        Axis_idx = 0;
+    } else if (Axis_name == "OY") {
+        Axis_idx = 1;
+    } else if (Axis_name == "OZ") {
+        Axis_idx = 2;
+    } else {
+        LOG_ERROR("Unknown axis: " << Axis_name);
+        return false;
+    }
 
-            if (Axis_name == "OX") {
-                obj->SetAng_Roll_deg(obj->GetAng_Roll_deg() + stepAngle);
-            } else if (Axis_name == "OY") {
-                obj->SetAng_Pitch_deg(obj->GetAng_Pitch_deg() + stepAngle);
-            } else if (Axis_name == "OZ") {
-                obj->SetAng_Yaw_deg(obj->GetAng_Yaw_deg() + stepAngle);
-            } else {
-                std::cerr << "Unknown axis: " << Axis_name << std::endl;
-                return false;
-            }
-        }
+    if (Angle_speed <= 0) {
+        LOG_ERROR("Invalid angular speed: " << Angle_speed);
+        return false;
+    }
 
-        std::ostringstream commandStream;
-        commandStream << "UpdateObj Name=" << Object_name.c_str()
-                      << " RotXYZ_deg=(" << obj->GetAng_Roll_deg() << ","
-                      << obj->GetAng_Pitch_deg() << "," << obj->GetAng_Yaw_deg() << ")\n";
+    Angle_done = 0;
+    return true;
+}
 
-        std::string command = commandStream.str();
 
-        rComChann.LockAccess();
-        try {
-            dynamic_cast<Sender&>(rComChann).SendCommand(command);
-        } catch (...) {
-            rComChann.UnlockAccess();
-            throw;
+/*!
+ *
+ */
+bool Interp4Rotate::Advance(double Dt_s, AbstractScene &rScn, AbstractComChannel &rComChann) {
+    const double remaining = std::fabs(Angle) - Angle_done;
+    const double step = std::min(Angle_speed * Dt_s, remaining);
+    const double stepAngle = Angle < 0 ? -step : step;
+    Angle_done += step;
+
+    {
+        std::lock_guard<std::mutex> lock(*pObjMutex);   // Only this object is locked
+
+        switch (Axis_idx) {
+            case 0: pObj->SetAng_Roll_deg(pObj->GetAng_Roll_deg() + stepAngle); break;
+            case 1: pObj->SetAng_Pitch_deg(pObj->GetAng_Pitch_deg() + stepAngle); break;
+            default: pObj->SetAng_Yaw_deg(pObj->GetAng_Yaw_deg() + stepAngle); break;
         }
-        rComChann.UnlockAccess();
-
-        usleep(static_cast<int>(frameTimeMs * 1000));
     }
+    // At the end of the frame the scene sends the new world transforms of the object and its descendants.
 
-    return true;
+    return Angle_done < std::fabs(Angle);
 }
 
 
@@ -120,6 +153,41 @@ bool Interp4Rotate::ReadParams(std::istream& Strm_CmdsList)
 }
 
 
+/*!
+ *
+ */
+bool Interp4Rotate::ReadParams(TokenCursor& rCursor)
+{
+  rCursor >> Object_name >> Axis_name >> Angle_speed >> Angle;
+  return static_cast<bool>(rCursor);
+}
+
+
+/*!
+ *
+ */
+bool Interp4Rotate::SaveParams(std::string& rBuffer) const
+{
+  progcache::PutString(rBuffer, Object_name);
+  progcache::PutString(rBuffer, Axis_name);
+  progcache::Put(rBuffer, Angle_speed);
+  progcache::Put(rBuffer, Angle);
+  return true;
+}
+
+
+/*!
+ *
+ */
+bool Interp4Rotate::LoadParams(std::string_view& rData)
+{
+  return progcache::GetString(rData, Object_name)
+      && progcache::GetString(rData, Axis_name)
+      && progcache::Get(rData, Angle_speed)
+      && progcache::Get(rData, Angle);
+}
+
+
 /*!
  *
  */
@@ -134,5 +202,5 @@ AbstractInterp4Command* Interp4Rotate::CreateCmd()
  */
 void Interp4Rotate::PrintSyntax() const
 {
-  cout << "   Rotate NazwaObiektu NazwaOsi SzybkoscKatowa[stopnie/s] KatObrotu[stopnie]" << endl;
+  LOG_INFO("   Rotate NazwaObiektu NazwaOsi SzybkoscKatowa[stopnie/s] KatObrotu[stopnie]");
 }
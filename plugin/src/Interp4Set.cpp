@@ -1,12 +1,15 @@
 #include <iostream>
-#include <sstream>
 #include "Interp4Set.hh"
+#include "CommandArena.hh"
+#include "ProgramCache.hh"
+#include "Logger.hh"
 
 using std::cout;
 using std::endl;
 
 extern "C" {
   AbstractInterp4Command* CreateCmd(void);
+  AbstractInterp4Command* CreateCmdIn(CommandArena &rArena);
   const char* GetCmdName() { return "Set"; }
 }
 
@@ -17,6 +20,13 @@ AbstractInterp4Command* CreateCmd(void) {
   return Interp4Set::CreateCmd();
 }
 
+/*!
+ * \brief Factory function creating an Interp4Set command in the script's arena.
+ */
+AbstractInterp4Command* CreateCmdIn(CommandArena &rArena) {
+  return rArena.Create<Interp4Set>();
+}
+
 /*!
  * \brief Default constructor.
  */
@@ -24,17 +34,18 @@ Interp4Set::Interp4Set()
   : Coordinate_X(0), Coordinate_Y(0), Coordinate_Z(0),
     Angle_X(0), Angle_Y(0), Angle_Z(0),
     Scale_X(1), Scale_Y(1), Scale_Z(1), // Default scale to 1
-    Color_R(255), Color_G(255), Color_B(255) {} // Default color to white
+    Color_R(255), Color_G(255), Color_B(255), // Default color to white
+    pObj(nullptr) {}
 
 /*!
  * \brief Print the command for debugging.
  */
-void Interp4Set::PrintCmd() const {
-  cout << GetCmdName() << ": "  << Object_name << " "
+void Interp4Set::PrintCmd(std::ostream &rOut) const {
+  rOut << GetCmdName() << ": "  << Object_name << " "
        << Coordinate_X << " " << Coordinate_Y << " " << Coordinate_Z << " "
        << Angle_X << " " << Angle_Y << " " << Angle_Z << " "
        << Scale_X << " " << Scale_Y << " " << Scale_Z << " "
-       << Color_R << " " << Color_G << " " << Color_B << endl;
+       << Color_R << " " << Color_G << " " << Color_B;
 }
 
 /*!
@@ -48,35 +59,31 @@ const char* Interp4Set::GetCmdName() const {
  * \brief Execute the command by sending it to the graphical server.
  */
 bool Interp4Set::ExecCmd(AbstractScene &rScn, const char *sMobObjName, AbstractComChannel &rComChann) {
-  	std::cout << "ExecCmd Interp4Set" << std::endl;
-    AbstractMobileObj* obj = rScn.FindMobileObj(Object_name.c_str());
+    LOG_DEBUG("ExecCmd Interp4Set");
 
-    if (!obj) {
-        std::cerr << "Object not found: " << Object_name << std::endl;
+    if (!pObj && !BindObjects(rScn)) {   // Not bound while loading
         return false;
     }
 
-    std::ostringstream commandStream;
-    commandStream << "AddObj Name=" << Object_name
-                  << " Scale=(" << Scale_X << "," << Scale_Y << "," << Scale_Z << ")"
-                  << " Shift=(" << Coordinate_X << "," << Coordinate_Y << "," << Coordinate_Z << ")"
-                  << " RotXYZ_deg=(" << Angle_X << "," << Angle_Y << "," << Angle_Z << ")"
-                  << " RGB=(" << Color_R << "," << Color_G << "," << Color_B << ")\n";
-
-    std::string command = commandStream.str();
+    const ObjDefinition def = {
+        {Scale_X, Scale_Y, Scale_Z},
+        {Coordinate_X, Coordinate_Y, Coordinate_Z},
+        {Angle_X, Angle_Y, Angle_Z},
+        {Color_R, Color_G, Color_B}
+    };
 
     // Lock access to the channel while sending the command
     rComChann.LockAccess();
     try {
-		std::cout << "Before SendCommand" << std::endl;
-        dynamic_cast<Sender&>(rComChann).SendCommand(command);
+        LOG_TRACE("Before SendAddObj");
+        rComChann.SendAddObj(Object_name, def);
     } catch (...) {
-		std::cerr << "Exception occurred while sending command." << std::endl;
+        LOG_ERROR("Exception occurred while sending command.");
         rComChann.UnlockAccess();
         throw;
     }
 
-	std::cout << "Before UnlockAccess" << std::endl;
+    LOG_TRACE("Before UnlockAccess");
     rComChann.UnlockAccess();
 
     return true;
@@ -94,6 +101,62 @@ bool Interp4Set::ReadParams(std::istream& Strm_CmdsList) {
   return true;
 }
 
+/*!
+ * \brief Reads the parameters straight from the script line.
+ */
+bool Interp4Set::ReadParams(TokenCursor& rCursor) {
+  rCursor >> Object_name
+          >> Coordinate_X >> Coordinate_Y >> Coordinate_Z
+          >> Angle_X >> Angle_Y >> Angle_Z
+          >> Scale_X >> Scale_Y >> Scale_Z
+          >> Color_R >> Color_G >> Color_B;
+  return static_cast<bool>(rCursor);
+}
+
+/*!
+ * \brief Stores the parameters in the program cache.
+ */
+bool Interp4Set::SaveParams(std::string& rBuffer) const {
+  progcache::PutString(rBuffer, Object_name);
+  for (double value : {Coordinate_X, Coordinate_Y, Coordinate_Z, Angle_X, Angle_Y, Angle_Z,
+                       Scale_X, Scale_Y, Scale_Z}) {
+    progcache::Put(rBuffer, value);
+  }
+  for (int value : {Color_R, Color_G, Color_B}) {
+    progcache::Put(rBuffer, static_cast<std::int32_t>(value));
+  }
+  return true;
+}
+
+/*!
+ * \brief Restores the parameters stored by SaveParams().
+ */
+bool Interp4Set::LoadParams(std::string_view& rData) {
+  if (!progcache::GetString(rData, Object_name)) return false;
+  for (double* pValue : {&Coordinate_X, &Coordinate_Y, &Coordinate_Z, &Angle_X, &Angle_Y, &Angle_Z,
+                         &Scale_X, &Scale_Y, &Scale_Z}) {
+    if (!progcache::Get(rData, *pValue)) return false;
+  }
+  for (int* pValue : {&Color_R, &Color_G, &Color_B}) {
+    std::int32_t value;
+    if (!progcache::Get(rData, value)) return false;
+    *pValue = value;
+  }
+  return true;
+}
+
+/*!
+ * \brief Resolve the target object once, before the command is executed.
+ */
+bool Interp4Set::BindObjects(AbstractScene &rScn) {
+  pObj = rScn.FindMobileObj(Object_name.c_str());
+  if (!pObj) {
+    LOG_ERROR("Object not found: " << Object_name);
+    return false;
+  }
+  return true;
+}
+
 /*!
  * \brief Factory method for creating an Interp4Set command.
  */
@@ -105,7 +168,7 @@ AbstractInterp4Command* Interp4Set::CreateCmd() {
  * \brief Print syntax for the command.
  */
 void Interp4Set::PrintSyntax() const {
-  cout << "   Set <ObjectName> <X[m]> <Y[m]> <Z[m]> <AngleX[deg]> <AngleY[deg]> <AngleZ[deg]> "
-       << "<ScaleX> <ScaleY> <ScaleZ> <R> <G> <B>" << endl;
+  LOG_INFO("   Set <ObjectName> <X[m]> <Y[m]> <Z[m]> <AngleX[deg]> <AngleY[deg]> <AngleZ[deg]> "
+           << "<ScaleX> <ScaleY> <ScaleZ> <R> <G> <B>");
 }
 
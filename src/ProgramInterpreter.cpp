@@ -1,10 +1,19 @@
 #include "ProgramInterpreter.hh"
-#include <iostream>
+#include "Logger.hh"
+#include "ScriptLexer.hh"
+#include "ProgramCache.hh"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
 #include <fstream>
+#include <iostream>
 #include <memory>
 #include <string>
 #include <sstream>
-#include <thread>
+#include <chrono>
+#include <stdexcept>
+#include <unordered_map>
+#include <sys/stat.h>
 #include <xercesc/sax2/SAX2XMLReader.hpp>
 #include <xercesc/sax2/XMLReaderFactory.hpp>
 #include <xercesc/util/XMLString.hpp>
@@ -12,34 +21,278 @@
 using namespace xercesc;
 
 bool ProgramInterpreter::Init(const std::string& configPath, const std::string& commandsPath) {
-    if (!ParseConfigurationFile(configPath)) {
-        std::cerr << "Failed to load configuration from: " << configPath << std::endl;
+    std::uint64_t cacheKey = 0;
+    const bool useCache = !cachePath.empty() && ComputeCacheKey(configPath, commandsPath, cacheKey);
+    const CacheResult cached = useCache ? LoadProgramCache(cacheKey) : CacheResult::Missed;
+    if (cached == CacheResult::Failed) {
+        std::cerr << "Failed to load the program from the cache: " << cachePath
+                  << " (remove it to rebuild it)" << std::endl;
         return false;
     }
 
-    if (!LoadLibraries()) {
-        std::cerr << "Failed to load libraries from configuration." << std::endl;
-        return false;
-    }
+    if (cached == CacheResult::Missed) {
+        if (!ParseConfigurationFile(configPath)) {
+            std::cerr << "Failed to load configuration from: " << configPath << std::endl;
+            return false;
+        }
 
-    if (!LoadObjects()) {
-        std::cerr << "Failed to load objects into the scene." << std::endl;
-        return false;
-    }
+        if (!LoadLibraries()) {
+            std::cerr << "Failed to load libraries from configuration." << std::endl;
+            return false;
+        }
 
-    if (!LoadCommands(commandsPath)) {
-        std::cerr << "Failed to load commands from: " << commandsPath << std::endl;
-        return false;
+        if (!LoadObjects()) {
+            std::cerr << "Failed to load objects into the scene." << std::endl;
+            return false;
+        }
+
+        if (!LoadCommands(commandsPath)) {
+            std::cerr << "Failed to load commands from: " << commandsPath << std::endl;
+            return false;
+        }
+
+        if (useCache) {
+            SaveProgramCache(cacheKey);
+        }
     }
 
     std::cout << "Initialization successful!" << std::endl;
 
     config.Print();
-    config.PrintCommands();
+    if (verbose) {
+        config.PrintCommands();
+    }
 
     return true;
 }
 
+namespace {
+    /*!
+     * \brief Size and modification time (in nanoseconds) of a plugin in the libs directory.
+     */
+    bool StatLibrary(const std::string& libName, std::uint64_t& size, std::int64_t& mtime) {
+        struct stat info;
+        if (::stat(("libs/" + libName).c_str(), &info) != 0) return false;
+        size = static_cast<std::uint64_t>(info.st_size);
+        mtime = static_cast<std::int64_t>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+        return true;
+    }
+
+    /*!
+     * \brief Command of the script as stored in the program cache.
+     */
+    struct CachedCommand {
+        std::uint32_t Lib;          //!< Index of the library providing the command
+        std::uint32_t Line;         //!< Line of the script
+        std::string_view Params;    //!< Parameters encoded by the plugin
+    };
+}
+
+bool ProgramInterpreter::ComputeCacheKey(const std::string& configPath, const std::string& commandsPath,
+                                         std::uint64_t& key) {
+    MappedFile configFile, commandsFile;
+    if (!configFile.Open(configPath) || !commandsFile.Open(commandsPath)) return false;
+
+    progcache::KeyHasher hasher;
+    hasher.Add(std::string_view(progcache::Magic, sizeof(progcache::Magic)));
+    for (int i = 0; i < 4; ++i) hasher.Mix(static_cast<unsigned char>(progcache::Version >> (8 * i)));
+    hasher.Add(configFile.View());
+    hasher.Add(commandsFile.View());
+    key = hasher.Get();
+    return true;
+}
+
+ProgramInterpreter::CacheResult ProgramInterpreter::LoadProgramCache(std::uint64_t key) {
+    const auto loadStart = std::chrono::steady_clock::now();
+    MappedFile file;
+    if (!file.Open(cachePath)) return CacheResult::Missed;
+
+    // Check the whole file before changing anything, so that a stale or damaged cache is just a miss
+    std::string_view data = file.View();
+    std::uint32_t version = 0, byteOrder = 0;
+    std::uint64_t storedKey = 0;
+    if (data.size() < sizeof(progcache::Magic)
+        || std::memcmp(data.data(), progcache::Magic, sizeof(progcache::Magic)) != 0) {
+        LOG_WARN("Not a program cache, it will be overwritten: " << cachePath);
+        return CacheResult::Missed;
+    }
+    data.remove_prefix(sizeof(progcache::Magic));
+    if (!progcache::Get(data, version) || !progcache::Get(data, byteOrder) || !progcache::Get(data, storedKey)
+        || version != progcache::Version || byteOrder != progcache::ByteOrderMark || storedKey != key) {
+        std::cout << "Program cache is out of date, reloading" << std::endl;
+        return CacheResult::Missed;
+    }
+
+    std::uint32_t libCount = 0;
+    std::vector<std::string> libs;
+    bool valid = progcache::Get(data, libCount);
+    for (std::uint32_t i = 0; valid && i < libCount; ++i) {
+        std::string name;
+        std::uint64_t size = 0, currentSize = 0;
+        std::int64_t mtime = 0, currentMtime = 0;
+        valid = progcache::GetString(data, name) && progcache::Get(data, size) && progcache::Get(data, mtime);
+        if (valid && (!StatLibrary(name, currentSize, currentMtime) || size != currentSize || mtime != currentMtime)) {
+            std::cout << "Plugin " << name << " changed since the program was cached, reloading" << std::endl;
+            return CacheResult::Missed;
+        }
+        libs.push_back(std::move(name));
+    }
+
+    std::uint32_t cubeCount = 0;
+    std::vector<CubeConfig> cubes;
+    valid = valid && progcache::Get(data, cubeCount);
+    for (std::uint32_t i = 0; valid && i < cubeCount; ++i) {
+        CubeConfig cube;
+        valid = progcache::GetString(data, cube.Name);
+        for (Vector3D* pVector : {&cube.Scale, &cube.Shift, &cube.Rotation, &cube.Translation, &cube.RGB}) {
+            for (int axis = 0; valid && axis < 3; ++axis) valid = progcache::Get(data, (*pVector)[axis]);
+        }
+        cubes.push_back(std::move(cube));
+    }
+
+    std::uint32_t commandCount = 0;
+    std::vector<CachedCommand> commands;
+    valid = valid && progcache::Get(data, commandCount) && commandCount <= data.size();
+    if (valid) commands.reserve(commandCount);
+    for (std::uint32_t i = 0; valid && i < commandCount; ++i) {
+        CachedCommand command;
+        valid = progcache::Get(data, command.Lib) && progcache::Get(data, command.Line)
+             && progcache::GetString(data, command.Params) && command.Lib < libs.size();
+        commands.push_back(command);
+    }
+
+    std::uint32_t spanCount = 0;
+    std::vector<Program::Span> spans;
+    valid = valid && progcache::Get(data, spanCount);
+    std::uint32_t covered = 0;
+    for (std::uint32_t i = 0; valid && i < spanCount; ++i) {
+        Program::Span span;
+        std::uint32_t parallel = 0;
+        valid = progcache::Get(data, span.Begin) && progcache::Get(data, span.Count) && progcache::Get(data, parallel)
+             && span.Begin == covered && span.Count <= commandCount - covered;
+        span.Parallel = parallel != 0;
+        covered += span.Count;
+        spans.push_back(span);
+    }
+    if (!valid || covered != commandCount || !data.empty()) {
+        LOG_WARN("Program cache is damaged, it will be overwritten: " << cachePath);
+        return CacheResult::Missed;
+    }
+
+    // Rebuild the configuration, the scene and the program
+    std::cout << "Loading the program from the cache: " << cachePath << std::endl;
+    for (const auto& lib : libs) config.AddLib(lib);
+    for (const auto& cube : cubes) config.AddCube(cube);
+    if (!LoadLibraries() || !LoadObjects()) return CacheResult::Failed;
+
+    Program& program = config.GetProgram();
+    scriptBegin = program.Size();
+    program.Reserve(program.Size() + commands.size());
+    loadStats = LoadStats();
+    for (const Program::Span& span : spans) {
+        if (span.Parallel) program.BeginParallel();
+        for (std::uint32_t i = span.Begin; i < span.Begin + span.Count; ++i) {
+            const std::string& cmdName = config.GetCommandName(libs[commands[i].Lib]);
+            LibInterface* libInterface = plugins.getInterface(cmdName);
+            AbstractInterp4Command* command = libInterface ? libInterface->CreateCmd(commandArena) : nullptr;
+            std::string_view params = commands[i].Params;
+            if (!command || !command->LoadParams(params) || !params.empty() || !command->BindObjects(scene)) {
+                std::cerr << "Error: line " << commands[i].Line << ": unable to restore command "
+                          << cmdName << " from the cache" << std::endl;
+                return CacheResult::Failed;
+            }
+            program.Append(command, commands[i].Line);
+            ++loadStats.CommandsPerType[cmdName];
+        }
+        if (span.Parallel) program.EndParallel();
+    }
+
+    loadStats.Bytes = file.View().size();
+    loadStats.TotalTime = std::chrono::steady_clock::now() - loadStart;
+    std::cout << "Loaded " << commands.size() << " commands from the cache in "
+              << loadStats.TotalTime.count() << " ms" << std::endl;
+    return CacheResult::Loaded;
+}
+
+void ProgramInterpreter::SaveProgramCache(std::uint64_t key) const {
+    std::string out(progcache::Magic, sizeof(progcache::Magic));
+    progcache::Put(out, progcache::Version);
+    progcache::Put(out, progcache::ByteOrderMark);
+    progcache::Put(out, key);
+
+    std::unordered_map<std::string, std::uint32_t> libIndex;   // By command name
+    progcache::Put(out, static_cast<std::uint32_t>(config.GetLibs().size()));
+    for (const auto& lib : config.GetLibs()) {
+        std::uint64_t size = 0;
+        std::int64_t mtime = 0;
+        if (!StatLibrary(lib, size, mtime)) {
+            LOG_WARN("Program not cached, unable to read plugin " << lib);
+            return;
+        }
+        libIndex.emplace(config.GetCommandName(lib), static_cast<std::uint32_t>(libIndex.size()));
+        progcache::PutString(out, lib);
+        progcache::Put(out, size);
+        progcache::Put(out, mtime);
+    }
+
+    progcache::Put(out, static_cast<std::uint32_t>(config.GetCubes().size()));
+    for (const auto& cube : config.GetCubes()) {
+        progcache::PutString(out, cube.Name);
+        for (const Vector3D* pVector : {&cube.Scale, &cube.Shift, &cube.Rotation, &cube.Translation, &cube.RGB}) {
+            for (int axis = 0; axis < 3; ++axis) progcache::Put(out, (*pVector)[axis]);
+        }
+    }
+
+    // Only the commands of the script; the Set commands of the objects are recreated by LoadObjects()
+    const Program& program = config.GetCommands();
+    const auto& records = program.GetRecords();
+    progcache::Put(out, static_cast<std::uint32_t>(records.size() - scriptBegin));
+    std::string params;
+    for (std::size_t i = scriptBegin; i < records.size(); ++i) {
+        auto lib = libIndex.find(records[i].pCmd->GetCmdName());
+        params.clear();
+        if (lib == libIndex.end() || !records[i].pCmd->SaveParams(params)) {
+            LOG_WARN("Program not cached, command " << records[i].pCmd->GetCmdName() << " cannot be stored");
+            return;
+        }
+        progcache::Put(out, lib->second);
+        progcache::Put(out, records[i].Line);
+        progcache::PutString(out, params);
+    }
+
+    std::vector<Program::Span> spans;
+    for (const Program::Span& span : program.GetSpans()) {
+        const std::size_t begin = std::max<std::size_t>(span.Begin, scriptBegin);
+        const std::size_t end = span.Begin + span.Count;
+        if (end <= begin) continue;
+        spans.push_back(Program::Span{static_cast<std::uint32_t>(begin - scriptBegin),
+                                      static_cast<std::uint32_t>(end - begin), span.Parallel});
+    }
+    progcache::Put(out, static_cast<std::uint32_t>(spans.size()));
+    for (const Program::Span& span : spans) {
+        progcache::Put(out, span.Begin);
+        progcache::Put(out, span.Count);
+        progcache::Put(out, static_cast<std::uint32_t>(span.Parallel));
+    }
+
+    // Replace the cache at once, so that a concurrent run never maps a partial file
+    const std::string tempPath = cachePath + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        file.write(out.data(), static_cast<std::streamsize>(out.size()));
+        if (!file) {
+            LOG_WARN("Unable to write the program cache: " << tempPath);
+            return;
+        }
+    }
+    if (std::rename(tempPath.c_str(), cachePath.c_str()) != 0) {
+        LOG_WARN("Unable to replace the program cache: " << cachePath);
+        std::remove(tempPath.c_str());
+        return;
+    }
+    std::cout << "Program cached in " << cachePath << " (" << out.size() << " bytes)" << std::endl;
+}
+
 bool ProgramInterpreter::ParseConfigurationFile(const std::string& configPath) {
     if (!InitializeXMLParser()) return false;
 
@@ -96,107 +349,264 @@ bool ProgramInterpreter::InitializeXMLParser() {
     return true;
 }
 
+namespace {
+    constexpr std::size_t MinChunkSize = 1024;  //!< Command lines below which a script is parsed by one thread
+
+    /*!
+     * \brief Parses a "#define NAME EXPRESSION" line.
+     *
+     * The expression may use the constants defined above it and is
+     * evaluated once, here.
+     */
+    bool ParseDefine(std::string_view line, const SymbolTable& constants, std::string_view& name, double& value) {
+        TokenCursor cursor(line.substr(7));
+        return cursor.Next(name) && constants.Evaluate(cursor.GetRest(), value);
+    }
+}
+
 bool ProgramInterpreter::LoadCommands(const std::string& commandsPath) {
     std::cout << "Loading comands..." << std::endl;
-    std::ifstream file(commandsPath);
-    if (!file.is_open()) {
+    MappedFile file;
+    if (!file.Open(commandsPath)) {
         std::cerr << "Error: Unable to open commands file: " << commandsPath << std::endl;
         return false;
     }
 
-    std::list<AbstractInterp4Command*> parallelCommands; // Temporary for parallel commands
-    bool inParallelBlock = false;
+    using Clock = std::chrono::steady_clock;
+    const auto loadStart = Clock::now();
+    loadStats = LoadStats();
+    loadStats.Bytes = file.View().size();
+
+    // Pass 1: constants, parallel blocks and the lines holding commands
+    std::vector<ScriptEntry> entries;
+    ScriptError scanError;
+    const bool inOrder = ScanScript(file.View(), entries, scanError);
+    loadStats.ScanTime = Clock::now() - loadStart;
+
+    // Pass 2: commands created in chunks, concurrently unless constants change along the way
+    std::size_t chunkCount = 1;
+    if (!inOrder && pool.GetThreadCount() > 1) {
+        chunkCount = std::min<std::size_t>(4 * pool.GetThreadCount(), entries.size() / MinChunkSize);
+        chunkCount = std::max<std::size_t>(chunkCount, 1);
+    }
+    std::vector<std::unique_ptr<ScriptChunk>> chunks;
+    for (std::size_t i = 0; i < chunkCount; ++i) {
+        chunks.push_back(std::make_unique<ScriptChunk>());
+    }
+
+    const std::size_t chunkSize = (entries.size() + chunkCount - 1) / chunkCount;
+    if (chunkCount == 1) {
+        ParseChunk(entries.data(), entries.size(), *chunks.front());
+    } else {
+        GroupBarrier barrier(chunkCount);
+        for (std::size_t i = 0; i < chunkCount; ++i) {
+            const std::size_t begin = std::min(i * chunkSize, entries.size());
+            const std::size_t count = std::min(chunkSize, entries.size() - begin);
+            ScriptChunk* pChunk = chunks[i].get();
+            pool.Submit([this, &entries, &barrier, begin, count, pChunk]() {
+                ParseChunk(entries.data() + begin, count, *pChunk);
+                barrier.Arrive();
+            });
+        }
+        barrier.Wait();
+    }
+
+    // Report the error closest to the beginning of the script, as a sequential load would
+    const ScriptError* pError = scanError.Line ? &scanError : nullptr;
+    for (const auto& chunk : chunks) {
+        if (chunk->Error.Line && (!pError || chunk->Error.Line <= pError->Line)) {
+            pError = &chunk->Error;
+        }
+        if (chunk->Error.Line) break;   // Later chunks start further on
+    }
+    if (pError) {
+        std::cerr << "Error: line " << pError->Line << ": " << pError->Message << std::endl;
+        return false;
+    }
+
+    // Merge in script order
+    for (auto& chunk : chunks) {
+        commandArena.Splice(chunk->Arena);
+        loadStats.ParseTime += chunk->Stats.ParseTime;
+        loadStats.BindTime += chunk->Stats.BindTime;
+        for (const auto& type : chunk->Stats.CommandsPerType) {
+            loadStats.CommandsPerType[type.first] += type.second;
+        }
+    }
+
+    Program& program = config.GetProgram();
+    scriptBegin = program.Size();
+    program.Reserve(program.Size() + entries.size());
+    for (const ScriptEntry& entry : entries) {
+        switch (entry.Type) {
+            case ScriptEntry::Kind::ParallelStart: program.BeginParallel(); break;
+            case ScriptEntry::Kind::ParallelEnd:   program.EndParallel();   break;
+            case ScriptEntry::Kind::Command:       program.Append(entry.pCmd, entry.Line); break;
+            case ScriptEntry::Kind::Define:        break;
+        }
+    }
+
+    loadStats.Chunks = chunkCount;
+    loadStats.TotalTime = Clock::now() - loadStart;
+    PrintLoadStats();
+
+    return true;
+}
+
+bool ProgramInterpreter::ScanScript(std::string_view script, std::vector<ScriptEntry>& entries, ScriptError& error) {
+    ScriptLexer lexer(script);
+    std::string_view line;
+    bool inParallel = false;
+    bool inOrder = false;
+    std::size_t parallelLine = 0;
+
+    while (lexer.NextLine(line)) {
+        const auto lineNumber = static_cast<std::uint32_t>(lexer.GetLineNumber());
 
-    std::string line;
-    while (std::getline(file, line)) {
         // Ignore empty lines or comments
-        if (line.empty() || line[0] == '#' || line.substr(0, 2) == "//") {
-            if (line.find("#define") == 0) {
-                std::istringstream iss(line.substr(8));
-                std::string name;
-                double value;
-                iss >> name >> value;
-                config.AddConstant(name, value);
-            }
+        if (line.empty() || line[0] == '#' || line.compare(0, 2, "//") == 0) {
+            if (line.compare(0, 7, "#define") != 0) continue;
 
+            if (!entries.empty()) {     // Commands above use the previous value
+                entries.push_back(ScriptEntry{ScriptEntry::Kind::Define, lineNumber, line});
+                inOrder = true;
+                continue;
+            }
+            std::string_view name;
+            double value;
+            if (!ParseDefine(line, config.GetConstants(), name, value)) {
+                error = ScriptError{lineNumber, "invalid #define"};
+                return inOrder;
+            }
+            config.AddConstant(name, value);
             continue;
         }
 
         // Detect ParallelStart and ParallelEnd
         if (line == "ParalelStart") {
-            if (inParallelBlock) {
-                std::cerr << "Error: Nested ParalelStart detected" << std::endl;
-                return false;
+            if (inParallel) {
+                error = ScriptError{lineNumber, "Nested ParalelStart detected"};
+                return inOrder;
             }
-            inParallelBlock = true;
-            parallelCommands.clear();
+            inParallel = true;
+            parallelLine = lineNumber;
+            entries.push_back(ScriptEntry{ScriptEntry::Kind::ParallelStart, lineNumber, line});
             continue;
         }
 
         if (line == "ParalelEnd") {
-            if (!inParallelBlock) {
-                std::cerr << "Error: ParalelEnd without matching ParalelStart" << std::endl;
-                return false;
+            if (!inParallel) {
+                error = ScriptError{lineNumber, "ParalelEnd without matching ParalelStart"};
+                return inOrder;
             }
-
-            config.AddParallelCommands(parallelCommands);
-            inParallelBlock = false;
+            inParallel = false;
+            entries.push_back(ScriptEntry{ScriptEntry::Kind::ParallelEnd, lineNumber, line});
             continue;
         }
 
-        line = config.SubstituteConstants(line);
+        if (TokenCursor(line).AtEnd()) continue;    // Whitespace only
+        entries.push_back(ScriptEntry{ScriptEntry::Kind::Command, lineNumber, line});
+    }
+
+    loadStats.Lines = lexer.GetLineNumber();
+    if (inParallel) {   // Reported at the end, after the errors of the commands inside the block
+        error = ScriptError{lexer.GetLineNumber(),
+                            "Unclosed ParalelStart block opened at line " + std::to_string(parallelLine)};
+    }
+    return inOrder;
+}
 
-        //Parse command
-        std::istringstream stream(line);
-        std::string cmdName;
-        stream >> cmdName;
+void ProgramInterpreter::ParseChunk(ScriptEntry* pFirst, std::size_t count, ScriptChunk& chunk) {
+    using Clock = std::chrono::steady_clock;
+    std::string cmdName;
+
+    for (ScriptEntry* pEntry = pFirst; pEntry != pFirst + count; ++pEntry) {
+        if (pEntry->Type == ScriptEntry::Kind::Define) {   // Only when the chunks are parsed in order
+            std::string_view name;
+            double value;
+            if (!ParseDefine(pEntry->Text, config.GetConstants(), name, value)) {
+                chunk.Error = ScriptError{pEntry->Line, "invalid #define"};
+                return;
+            }
+            config.AddConstant(name, value);
+            continue;
+        }
+        if (pEntry->Type != ScriptEntry::Kind::Command) continue;
 
-        //std::cout << cmdName << "\n";
+        //Parse command
+        const auto parseStart = Clock::now();
+        TokenCursor cursor(pEntry->Text, &config.GetConstants());
+        std::string_view token;
+        cursor.Next(token);
+        cmdName.assign(token.data(), token.size());
 
         LibInterface* libInterface = plugins.getInterface(cmdName);
         if (!libInterface) {
-            std::cerr << "Error: Command not found in plugins: " << cmdName << std::endl;
-            return false;
+            chunk.Error = ScriptError{pEntry->Line, "Command not found in plugins: " + cmdName};
+            return;
         }
 
-        auto command = libInterface->CreateCmd();
-        if (!command->ReadParams(stream)) {
-            std::cerr << "Error reading parameters for command: " << cmdName << std::endl;
-            return false;
-        }
-
-        //command->PrintCmd();
+        try {
+            pEntry->pCmd = libInterface->CreateCmd(chunk.Arena);   // Owned by the arena
+            if (!pEntry->pCmd) {
+                chunk.Error = ScriptError{pEntry->Line, "Unable to create command: " + cmdName};
+                return;
+            }
+            if (!pEntry->pCmd->ReadParams(cursor)) {
+                chunk.Error = ScriptError{pEntry->Line, "invalid parameters for command: " + cmdName};
+                return;
+            }
+            const auto bindStart = Clock::now();
+            chunk.Stats.ParseTime += bindStart - parseStart;
 
-        // Add the command to the appropriate list
-        if (inParallelBlock) {
-            parallelCommands.push_back(command);
-        } else {
-            config.AddStandaloneCommand(command);
+            // Resolve object names now, so that execution needs no scene lookups
+            if (!pEntry->pCmd->BindObjects(scene)) {
+                chunk.Error = ScriptError{pEntry->Line, "command " + cmdName + " refers to an unknown object"};
+                return;
+            }
+            chunk.Stats.BindTime += Clock::now() - bindStart;
+        } catch (const std::exception& ex) {
+            chunk.Error = ScriptError{pEntry->Line, "command " + cmdName + " failed to load: " + ex.what()};
+            return;
         }
+        ++chunk.Stats.CommandsPerType[cmdName];
     }
+}
 
-    if (inParallelBlock) {
-        std::cerr << "Error: Unclosed ParalelStart block" << std::endl;
-        return false;
+void ProgramInterpreter::PrintLoadStats() const {
+    std::size_t commandCount = 0;
+    for (const auto& type : loadStats.CommandsPerType) commandCount += type.second;
+
+    std::cout << "Loaded " << commandCount << " commands from " << loadStats.Lines << " lines in "
+              << loadStats.TotalTime.count() << " ms using " << loadStats.Chunks << " chunk(s) (scan "
+              << loadStats.ScanTime.count() << " ms, parse " << loadStats.ParseTime.count()
+              << " ms, bind " << loadStats.BindTime.count() << " ms, "
+              << (loadStats.TotalTime.count() > 0 ? loadStats.Bytes / 1e3 / loadStats.TotalTime.count() : 0.0)
+              << " MB/s)" << std::endl;
+    for (const auto& type : loadStats.CommandsPerType) {
+        std::cout << "  " << type.first << ": " << type.second << std::endl;
     }
-
-    return true;
 }
 
 bool ProgramInterpreter::LoadObjects() {
     std::cout << "Loading objects into the scene..." << std::endl;
 
+    scene.GetStore().Reserve(config.GetCubes().size());
+
     for (const auto& cubeConfig : config.GetCubes()) {
-        // Create a new Cuboid object for the scene
-        auto* cuboid = new Cuboid(
+        // Create a new Cuboid object for the scene, its state lives in the scene's store
+        auto* cuboid = scene.AddCuboid(
             cubeConfig.Name,
             cubeConfig.Translation,
             cubeConfig.Scale,
             cubeConfig.Rotation,
             cubeConfig.RGB
         );
+        if (!cuboid) {
+            std::cerr << "Error: Object " << cubeConfig.Name << " is defined more than once." << std::endl;
+            return false;
+        }
 
-        scene.AddMobileObj(cuboid);
         std::cout << "Added object: " << cuboid->GetName() << std::endl;
 
         // Create a new instance of the 'Set' command for this object
@@ -206,7 +616,7 @@ bool ProgramInterpreter::LoadObjects() {
             return false;
         }
 
-        AbstractInterp4Command* setCommand = libInterface->CreateCmd();
+        AbstractInterp4Command* setCommand = libInterface->CreateCmd(commandArena);
         if (!setCommand) {
             std::cerr << "Error: Unable to create 'Set' command instance." << std::endl;
             return false;
@@ -230,13 +640,22 @@ bool ProgramInterpreter::LoadObjects() {
 
         if (!setCommand->ReadParams(stream)) {
             std::cerr << "Error: Unable to read parameters for 'Set' command." << std::endl;
-            delete setCommand;
+            return false;
+        }
+
+        if (!setCommand->BindObjects(scene)) {
+            std::cerr << "Error: Unable to bind 'Set' command to object: " << cubeConfig.Name << std::endl;
             return false;
         }
 
         config.AddStandaloneCommand(setCommand);
     }
 
+    // Link the objects by their dotted names, e.g. Podstawa.Ramie1 is a child of Podstawa
+    scene.BuildHierarchy();
+    std::cout << "Scene graph: " << scene.GetGraph().Size() << " objects, "
+              << scene.GetGraph().GetRootCount() << " roots" << std::endl;
+
     return true;
 }
 
@@ -256,6 +675,60 @@ bool ProgramInterpreter::LoadLibraries() {
     return true;
 }
 
+void ProgramInterpreter::RunGroup(const Program::Record* pFirst, std::size_t count, std::size_t groupIndex) {
+    const auto groupStart = std::chrono::steady_clock::now();
+    GroupBarrier barrier(count);
+
+    for (const Program::Record* pRecord = pFirst; pRecord != pFirst + count; ++pRecord) {
+        AbstractInterp4Command* command = pRecord->pCmd;
+
+        if (LOG_IS_ENABLED(APM_LOG_DEBUG)) {
+            std::ostringstream text;
+            command->PrintCmd(text);
+            LOG_DEBUG("New command: " << text.str());
+        }
+
+        if (command->IsDelay()) {
+            const std::chrono::duration<double, std::milli> delay(std::max(0.0, command->GetDelay_ms()));
+            animations.AddTimer(std::chrono::duration_cast<std::chrono::steady_clock::duration>(delay),
+                                [&barrier]() { barrier.Arrive(); });
+            continue;
+        }
+
+        if (command->IsAnimation()) {
+            if (command->StartAnimation(scene, sender)) {
+                animations.Add(command, [&barrier]() { barrier.Arrive(); });
+            } else {
+                LOG_ERROR("Unable to start command: " << command->GetCmdName());
+                barrier.Arrive();
+            }
+            continue;
+        }
+
+        pool.Submit([command, &barrier, this]() {
+            try {
+                command->ExecCmd(scene, command->GetCmdName(), sender);
+            } catch (const std::exception& ex) {
+                LOG_ERROR("Command " << command->GetCmdName() << " failed: " << ex.what());
+            } catch (...) {
+                LOG_ERROR("Command " << command->GetCmdName() << " failed.");
+            }
+            barrier.Arrive();
+        });
+    }
+
+    barrier.Wait();
+
+    const std::chrono::duration<double, std::milli> groupTime =
+        std::chrono::steady_clock::now() - groupStart;
+    if (count > 1) {
+        LOG_INFO("Group " << groupIndex << " (" << count << " parallel commands) finished in "
+                 << groupTime.count() << " ms");
+    } else {
+        LOG_DEBUG("Group " << groupIndex << " (1 command) finished in " << groupTime.count() << " ms");
+    }
+}
+
 void ProgramInterpreter::Run() {
     std::cout << "Running program..." << std::endl;
 
@@ -265,28 +738,47 @@ void ProgramInterpreter::Run() {
     }
 
     std::cout << "Connection OK..." << std::endl;
+    if (!sender.SetWireFormat(wireFormat)) {
+        std::cerr << "Failed to select the wire format." << std::endl;
+        return;
+    }
+    sender.SetFrameBatching(true);
+    sender.SetDeltaUpdates(true);
+    sender.SetQuantization(shiftQuantum, angleQuantum);
 
-    const auto& commands = config.GetCommands();
-    std::list<std::thread> threads;
+    if (asyncSending && !sender.StartAsync(4096, asyncPolicy)) {
+        std::cerr << "Failed to start asynchronous sending, falling back to synchronous mode." << std::endl;
+    }
 
-    for (const auto& commandGroup : commands) {
-        for (auto* command : commandGroup) {
-            std::cout << "New command" << std::endl;
-            command->PrintCmd();
+    std::cout << "Worker threads: " << pool.GetThreadCount() << std::endl;
 
-            threads.emplace_back([command, this]() {
-                command->ExecCmd(scene, command->GetCmdName(), sender);
-            });
-        }
+    const Program& program = config.GetCommands();
+    std::size_t groupIndex = 0;
 
-        for (auto& thread : threads) {
-            if (thread.joinable()) {
-                thread.join();
-            }
+    for (const Program::Span& span : program.GetSpans()) {
+        const Program::Record* pSpan = program.GetRecords().data() + span.Begin;
+        if (span.Parallel) {
+            RunGroup(pSpan, span.Count, ++groupIndex);
+            continue;
         }
+        for (std::uint32_t i = 0; i < span.Count; ++i) {   // Sequential commands run one at a time
+            RunGroup(pSpan + i, 1, ++groupIndex);
+        }
+    }
 
-        threads.clear();
+    if (asyncSending) {
+        sender.StopAsync();  // Sends everything which is still queued
+
+        const SenderStats stats = sender.GetStats();
+        std::cout << "Sender queue: peak depth " << stats.PeakQueueDepth
+                  << ", queued " << stats.Queued
+                  << ", dropped " << stats.Dropped << std::endl;
     }
 
+    const SenderStats stats = sender.GetStats();
+    std::cout << "Object updates: " << stats.UpdatesSuppressed << " suppressed, "
+              << stats.UpdateBytesSent << " of " << stats.UpdateBytesFull << " bytes sent ("
+              << stats.UpdateBytesFull - stats.UpdateBytesSent << " saved)" << std::endl;
+
     std::cout << "Program finished executing commands." << std::endl;
 }
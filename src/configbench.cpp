@@ -0,0 +1,196 @@
+/*!
+ * \file
+ * \brief Microbenchmark of reading the \p "Cube" elements of config.xml.
+ *
+ * Generates a configuration with many cubes and feeds their attributes to
+ * XMLInterp4Config::startElement() through a stand-in of
+ * xercesc::Attributes, so that only the handler is timed, not the
+ * tokenizer and validator of Xerces. With \p -o the generated
+ * configuration is also written out, to time the whole parse with the
+ * interpreter.
+ * \code
+ *   make bench
+ *   ./configbench -n 100000 -r 10 -o /tmp/config100k.xml
+ * \endcode
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "xmlinterp.hh"
+
+using namespace std;
+
+
+/*!
+ * \brief Name and values of the attributes of the i-th generated cube.
+ *
+ * Cubes come in chains of four ("C0", "C0.1", "C0.1.2", ...) and the
+ * vectors use the spellings accepted by the handler: signs, exponents
+ * and extra spaces.
+ */
+std::vector<std::pair<std::string, std::string>> CubeAttributes(std::size_t Ind, std::string& rParent) {
+    const std::string name = (Ind % 4 == 0) ? "C" + std::to_string(Ind) : rParent + "." + std::to_string(Ind % 4);
+    rParent = name;
+    const std::string x = std::to_string(Ind % 97);
+    return {
+        {"Name", name},
+        {"Shift", "0.5 0.5 0"},
+        {"Scale", " 1 1 +1e0 "},
+        {"RotXYZ_deg", x + " 0 -45.5"},
+        {"Trans_m", "1.25 " + x + " 0"},
+        {"RGB", "128 203 " + std::to_string(Ind % 256)}
+    };
+}
+
+
+/*!
+ * \brief Writes a configuration with the plugins and Count cubes.
+ */
+void WriteConfig(std::ostream& rOut, std::size_t Count) {
+    rOut << "<Config>\n  <Plugins>\n"
+         << "    <Lib Name=\"libInterp4Move.so\"/>\n"
+         << "    <Lib Name=\"libInterp4Rotate.so\"/>\n"
+         << "    <Lib Name=\"libInterp4Pause.so\"/>\n"
+         << "    <Lib Name=\"libInterp4Set.so\"/>\n"
+         << "  </Plugins>\n\n  <Objects>\n";
+    std::string parent;
+    for (std::size_t i = 0; i < Count; ++i) {
+        rOut << "    <Cube";
+        for (const auto& attr : CubeAttributes(i, parent)) rOut << ' ' << attr.first << "=\"" << attr.second << '"';
+        rOut << "/>\n";
+    }
+    rOut << "  </Objects>\n</Config>\n";
+}
+
+
+/*!
+ * \brief Text in the encoding of Xerces, for ASCII input.
+ */
+std::basic_string<XMLCh> ToXMLCh(const std::string& rText) {
+    return std::basic_string<XMLCh>(rText.begin(), rText.end());
+}
+
+
+/*!
+ * \brief Attributes of one element, held as the parser would pass them.
+ *
+ * Only the lookups by index are used by XMLInterp4Config; the lookups
+ * by name are answered by a linear search.
+ */
+class StandInAttributes : public xercesc::Attributes {
+private:
+    std::vector<std::basic_string<XMLCh>> Names;
+    std::vector<std::basic_string<XMLCh>> Values;
+    const XMLCh Empty[1] = {0};
+
+    int Find(const XMLCh* pName) const {
+        for (std::size_t i = 0; i < Names.size(); ++i) {
+            if (Names[i] == pName) return static_cast<int>(i);
+        }
+        return -1;
+    }
+
+public:
+    explicit StandInAttributes(const std::vector<std::pair<std::string, std::string>>& rAttrs) {
+        for (const auto& attr : rAttrs) {
+            Names.push_back(ToXMLCh(attr.first));
+            Values.push_back(ToXMLCh(attr.second));
+        }
+    }
+
+    XMLSize_t getLength() const override { return Names.size(); }
+    const XMLCh* getURI(const XMLSize_t) const override { return Empty; }
+    const XMLCh* getLocalName(const XMLSize_t Ind) const override { return Names[Ind].c_str(); }
+    const XMLCh* getQName(const XMLSize_t Ind) const override { return Names[Ind].c_str(); }
+    const XMLCh* getType(const XMLSize_t) const override { return Empty; }
+    const XMLCh* getValue(const XMLSize_t Ind) const override { return Values[Ind].c_str(); }
+
+    bool getIndex(const XMLCh* const, const XMLCh* const pLocalPart, XMLSize_t& rInd) const override {
+        return getIndex(pLocalPart, rInd);
+    }
+    int getIndex(const XMLCh* const, const XMLCh* const pLocalPart) const override { return Find(pLocalPart); }
+    bool getIndex(const XMLCh* const pQName, XMLSize_t& rInd) const override {
+        const int ind = Find(pQName);
+        if (ind < 0) return false;
+        rInd = static_cast<XMLSize_t>(ind);
+        return true;
+    }
+    int getIndex(const XMLCh* const pQName) const override { return Find(pQName); }
+    const XMLCh* getType(const XMLCh* const, const XMLCh* const) const override { return Empty; }
+    const XMLCh* getType(const XMLCh* const) const override { return Empty; }
+    const XMLCh* getValue(const XMLCh* const, const XMLCh* const pLocalPart) const override {
+        return getValue(pLocalPart);
+    }
+    const XMLCh* getValue(const XMLCh* const pQName) const override {
+        const int ind = Find(pQName);
+        return ind < 0 ? nullptr : Values[ind].c_str();
+    }
+};
+
+
+int main(int argc, char* argv[]) {
+    std::size_t count = 100000;
+    int repeats = 10;
+    std::string outPath;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "-n" && i + 1 < argc) {
+            count = std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "-r" && i + 1 < argc) {
+            repeats = std::atoi(argv[++i]);
+        } else if (arg == "-o" && i + 1 < argc) {
+            outPath = argv[++i];
+        } else {
+            cerr << "Usage: " << argv[0] << " [-n <cubes>] [-r <repeats>] [-o <config.xml>]" << endl;
+            return 1;
+        }
+    }
+    if (count == 0 || repeats <= 0) {
+        cerr << "*** Both the number of cubes and of repeats must be positive." << endl;
+        return 1;
+    }
+
+    if (!outPath.empty()) {
+        std::ofstream out(outPath);
+        WriteConfig(out, count);
+        if (!out) {
+            cerr << "*** Unable to write " << outPath << endl;
+            return 1;
+        }
+        cout << "Configuration written to " << outPath << endl;
+    }
+
+    const XMLCh xLib[] = {'L', 'i', 'b', 0};
+    const XMLCh xCube[] = {'C', 'u', 'b', 'e', 0};
+    const StandInAttributes lib(std::vector<std::pair<std::string, std::string>>{{"Name", "libInterp4Move.so"}});
+    std::vector<StandInAttributes> cubes;
+    cubes.reserve(count);
+    std::string parent;
+    for (std::size_t i = 0; i < count; ++i) cubes.emplace_back(CubeAttributes(i, parent));
+
+    auto readAll = [&] {
+        Configuration config;
+        XMLInterp4Config handler(config);
+        handler.startElement(nullptr, xLib, xLib, lib);
+        for (const StandInAttributes& attrs : cubes) handler.startElement(nullptr, xCube, xCube, attrs);
+        return config.GetCubes().size();
+    };
+
+    std::size_t read = readAll();   // Warm-up
+    const auto start = chrono::steady_clock::now();
+    for (int r = 0; r < repeats; ++r) read = readAll();
+    const chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+
+    cout << "Cubes: " << count << ", repeats: " << repeats << endl;
+    cout << fixed << setprecision(2)
+         << "  cube elements   " << setw(10) << elapsed.count() / repeats << " ms"
+         << setw(10) << 1e6 * elapsed.count() / (static_cast<double>(count) * repeats) << " ns/cube"
+         << "  (" << read << " cubes read)" << endl;
+    return 0;
+}
@@ -0,0 +1,343 @@
+/*!
+ * \file
+ * \brief Microbenchmark of the per-frame transform kernels.
+ *
+ * Compares, for a scene of many cuboids, the per-object path used
+ * before the batch kernels with the batch path used by the scene:
+ *  - Euler angles: kernels::EulerToMatrix() per object, against
+ *    kernels::EulerToMatrices(),
+ *  - world angles: kernels::MatrixToEuler() per object, against
+ *    kernels::MatricesToEuler(),
+ *  - a whole frame with every object animated (as by Move and Rotate):
+ *    the per-object update of the hierarchy (lock, read, convert, compose
+ *    and convert back one object at a time), against Scene::PublishChanges(),
+ *  - the operator chains of geom::Vector (`a + b*s - c`, Axpy(), Normalize()):
+ *    a vector with loops and a temporary per operator, as geom::Vector was
+ *    before the unrolled loops and expression templates, against Vector3D.
+ * \code
+ *   make bench
+ *   ./kernelbench -n 100000 -r 200
+ * \endcode
+ */
+
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "BatchKernels.hh"
+#include "Scene.hh"
+
+using namespace std;
+
+
+/*!
+ * \brief Channel counting the updates instead of sending them.
+ */
+class NullChannel : public AbstractComChannel {
+private:
+    std::mutex Guard;
+
+public:
+    std::size_t Updates = 0;    //!< Number of SendObjUpdate() calls
+
+    void Init(int) override {}
+    int GetSocket() const override { return -1; }
+    void LockAccess() override { Guard.lock(); }
+    void UnlockAccess() override { Guard.unlock(); }
+    std::mutex& UseGuard() override { return Guard; }
+    void BeginFrame() override {}
+    void EndFrame() override {}
+    void SendUpdate(const std::string&, std::string_view) override {}
+    void SendAddObj(const std::string&, const ObjDefinition&) override {}
+    void SendObjUpdate(const std::string&, const ObjUpdate&) override { ++Updates; }
+};
+
+
+/*!
+ * \brief Runs a benchmark body Repeats times and returns the time per object in nanoseconds.
+ */
+template<typename Body>
+double NsPerObject(std::size_t Count, int Repeats, Body&& Run) {
+    Run();  // Warm-up
+    const auto start = chrono::steady_clock::now();
+    for (int r = 0; r < Repeats; ++r) Run();
+    const chrono::duration<double, nano> elapsed = chrono::steady_clock::now() - start;
+    return elapsed.count() / (static_cast<double>(Count) * Repeats);
+}
+
+
+/*!
+ * \brief Prints one result line: the per-object and the batch time and their ratio.
+ */
+void Report(const char* sName, double PerObject_ns, double Batch_ns) {
+    cout << "  " << left << setw(16) << sName << right << fixed << setprecision(2)
+         << setw(10) << PerObject_ns << " ns" << setw(10) << Batch_ns << " ns"
+         << setw(9) << PerObject_ns / Batch_ns << "x" << endl;
+}
+
+
+/*!
+ * \brief Three-dimensional vector as geom::Vector was before the expression templates.
+ *
+ * Every operator loops over the coordinates and a binary operator returns
+ * a temporary, so `a + b*s - c` builds two of them.
+ */
+class LoopVector {
+private:
+    std::array<double, 3> Coord{};
+
+public:
+    LoopVector() = default;
+    LoopVector(double x, double y, double z) : Coord{x, y, z} {}
+
+    double operator[](unsigned int Ind) const { return Coord[Ind]; }
+
+    LoopVector& operator+=(const LoopVector& rArg) { for (unsigned int i = 0; i < 3; ++i) Coord[i] += rArg[i]; return *this; }
+    LoopVector& operator-=(const LoopVector& rArg) { for (unsigned int i = 0; i < 3; ++i) Coord[i] -= rArg[i]; return *this; }
+    LoopVector& operator*=(double Mul) { for (double& crd : Coord) crd *= Mul; return *this; }
+
+    LoopVector operator+(const LoopVector& rArg) const { return LoopVector(*this) += rArg; }
+    LoopVector operator-(const LoopVector& rArg) const { return LoopVector(*this) -= rArg; }
+    LoopVector operator*(double Mul) const { return LoopVector(*this) *= Mul; }
+
+    double operator&(const LoopVector& rArg) const {
+        double sum = 0;
+        for (unsigned int i = 0; i < 3; ++i) sum += Coord[i] * rArg[i];
+        return sum;
+    }
+    double Length() const { return std::sqrt(*this & *this); }
+    void Normalize() { const double d = Length(); for (double& crd : Coord) crd /= d; }
+};
+
+
+/*!
+ * \brief Times the vector chains on Count vectors, with the vector type Vec.
+ * \param rChain, rAxpy, rNormalize - receive the time per vector in nanoseconds.
+ */
+template<typename Vec>
+void VectorChains(std::size_t Count, int Repeats, double& rChain, double& rAxpy, double& rNormalize) {
+    std::vector<Vec> a, b, c, out(Count);
+    for (std::size_t i = 0; i < Count; ++i) {
+        const double x = static_cast<double>(i % 97) + 1;
+        a.emplace_back(x, 2 * x, 3 * x);
+        b.emplace_back(1 / x, x, 0.5);
+        c.emplace_back(x, 1, -x);
+    }
+    const double s = 0.25;
+    volatile double sink = 0;   // Keeps the results alive
+
+    rChain = NsPerObject(Count, Repeats, [&] {
+        for (std::size_t i = 0; i < Count; ++i) out[i] = a[i] + b[i] * s - c[i];
+        sink = sink + out[Count / 2][0];
+    });
+    rAxpy = NsPerObject(Count, Repeats, [&] {
+        for (std::size_t i = 0; i < Count; ++i) {
+            if constexpr (std::is_same<Vec, LoopVector>::value) out[i] += b[i] * s;
+            else out[i].Axpy(s, b[i]);
+        }
+        sink = sink + out[Count / 2][0];
+    });
+    rNormalize = NsPerObject(Count, Repeats, [&] {
+        for (std::size_t i = 0; i < Count; ++i) {
+            out[i] = a[i];
+            out[i].Normalize();
+        }
+        sink = sink + out[Count / 2][0];
+    });
+}
+
+
+/*!
+ * \brief Calls Add(name, position, scale, rotation, color) for Count cuboids in chains of four ("C0", "C0.1", "C0.1.2", ...).
+ */
+template<typename AddFn>
+void AddCuboids(std::size_t Count, AddFn&& Add) {
+    std::string parent;
+    for (std::size_t i = 0; i < Count; ++i) {
+        const std::string name = (i % 4 == 0) ? "C" + std::to_string(i) : parent + "." + std::to_string(i % 4);
+        const double x = static_cast<double>(i % 97);
+        Add(name, Vector3D(x, 1, 0), Vector3D(1, 1, 1), Vector3D(x, 2 * x, 3 * x), Vector3D(128, 128, 128));
+        parent = name;
+    }
+}
+
+
+/*!
+ * \brief The hierarchy update of a frame as done before the batch kernels.
+ *
+ * Same result as SceneGraph::Update(), but all objects are visited, and
+ * every changed one is locked, read, converted, composed and converted
+ * back to angles on its own.
+ * The ids of the store are already ordered parents first (see AddCuboids()).
+ */
+class PerObjectUpdate {
+private:
+    std::vector<SceneGraph::Transform> World;
+    std::vector<std::uint8_t> Moved;
+    std::vector<std::uint8_t> Dirty;
+    std::vector<ObjectStore::ObjId> DirtyIds;
+
+    static SceneGraph::Transform Compose(const SceneGraph::Transform* pParent, const Vector3D& rPos, const double* local) {
+        SceneGraph::Transform result;
+        if (!pParent) {
+            for (int i = 0; i < 9; ++i) result.R[i] = local[i];
+            for (int i = 0; i < 3; ++i) result.T[i] = rPos[i];
+            return result;
+        }
+        for (int r = 0; r < 3; ++r) {
+            for (int c = 0; c < 3; ++c) {
+                result.R[3 * r + c] = pParent->R[3 * r] * local[c] + pParent->R[3 * r + 1] * local[3 + c]
+                                    + pParent->R[3 * r + 2] * local[6 + c];
+            }
+            result.T[r] = pParent->R[3 * r] * rPos[0] + pParent->R[3 * r + 1] * rPos[1]
+                        + pParent->R[3 * r + 2] * rPos[2] + pParent->T[r];
+        }
+        return result;
+    }
+
+public:
+    explicit PerObjectUpdate(std::size_t Count) : World(Count), Moved(Count, 0), Dirty(Count, 0) {}
+
+    void Run(ObjectStore& rStore, const SceneGraph& rGraph, std::vector<std::mutex*>& rMutexes, AbstractComChannel& rChannel) {
+        rStore.TakeDirtyIds(DirtyIds);
+        for (ObjectStore::ObjId id : DirtyIds) Dirty[id] = 1;
+
+        ObjUpdate update;
+        update.Fields = ObjUpdate::HasShift | ObjUpdate::HasRotation;
+        for (ObjectStore::ObjId id = 0; id < World.size(); ++id) {
+            const ObjectStore::ObjId parent = rGraph.GetParent(id);
+            if (!Dirty[id] && (parent == SceneGraph::NoParent || !Moved[parent])) {
+                Moved[id] = 0;
+                continue;
+            }
+
+            Vector3D position, rotation;
+            {
+                std::lock_guard<std::mutex> lock(*rMutexes[id]);
+                if (Dirty[id]) rStore.ClearDirty(id);
+                position = rStore.Position(id);
+                rotation = rStore.Rotation(id);
+            }
+            Dirty[id] = 0;
+
+            double local[9];
+            kernels::EulerToMatrix(rotation, local);
+            const SceneGraph::Transform world = Compose(parent == SceneGraph::NoParent ? nullptr : &World[parent], position, local);
+            Moved[id] = !(world == World[id]);
+            if (Moved[id]) {
+                World[id] = world;
+                const Vector3D worldRotation = parent == SceneGraph::NoParent ? rotation : kernels::MatrixToEuler(world.R);
+                for (int i = 0; i < 3; ++i) {
+                    update.Shift[i] = world.T[i];
+                    update.RotXYZ_deg[i] = worldRotation[i];
+                }
+                rChannel.SendObjUpdate(rStore.Name(id), update);
+            }
+        }
+    }
+};
+
+
+int main(int argc, char* argv[]) {
+    std::size_t count = 10000;
+    int repeats = 500;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "-n" && i + 1 < argc) {
+            count = std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "-r" && i + 1 < argc) {
+            repeats = std::atoi(argv[++i]);
+        } else {
+            cerr << "Usage: " << argv[0] << " [-n <objects>] [-r <repeats>]" << endl;
+            return 1;
+        }
+    }
+    if (count == 0 || repeats <= 0) {
+        cerr << "*** Both the number of objects and of repeats must be positive." << endl;
+        return 1;
+    }
+
+    Scene scene;
+    scene.GetStore().Reserve(count);
+    std::vector<AbstractMobileObj*> objects;
+    std::vector<std::mutex*> mutexes;
+    AddCuboids(count, [&](const std::string& rName, const Vector3D& rPos, const Vector3D& rScale,
+                          const Vector3D& rRot, const Vector3D& rRgb) {
+        objects.push_back(scene.AddCuboid(rName, rPos, rScale, rRot, rRgb));
+        mutexes.push_back(&scene.GetObjMutex(objects.back()));
+    });
+    scene.BuildHierarchy();
+    ObjectStore& store = scene.GetStore();
+
+    cout << "Objects: " << count << ", repeats: " << repeats
+         << ", kernels: " << kernels::IsaName(kernels::ActiveIsa()) << endl;
+    cout << "  " << left << setw(16) << "" << right << setw(13) << "per object" << setw(13) << "batch" << endl;
+
+    // -- Euler angles to rotation matrices
+    std::vector<double> matrices(9 * count);
+    const double eulerPerObject = NsPerObject(count, repeats, [&] {
+        for (ObjectStore::ObjId id = 0; id < count; ++id) {
+            kernels::EulerToMatrix(store.Rotation(id), &matrices[9 * id]);
+        }
+    });
+    const double eulerBatch = NsPerObject(count, repeats, [&] {
+        kernels::EulerToMatrices(store.RotationData(), matrices.data(), count);
+    });
+    Report("euler matrices", eulerPerObject, eulerBatch);
+
+    // -- World rotation matrices back to Euler angles
+    std::vector<Vector3D> angles(count);
+    const double anglesPerObject = NsPerObject(count, repeats, [&] {
+        for (std::size_t i = 0; i < count; ++i) angles[i] = kernels::MatrixToEuler(&matrices[9 * i]);
+    });
+    const double anglesBatch = NsPerObject(count, repeats, [&] {
+        kernels::MatricesToEuler(matrices.data(), angles.data(), count);
+    });
+    Report("world angles", anglesPerObject, anglesBatch);
+
+    // -- Whole frame, as stepped by AnimationScheduler: the steps of Move and Rotate, then the update
+    const Vector3D shift(0.001, 0.002, 0);
+    auto step = [&] {
+        for (std::size_t i = 0; i < count; ++i) {
+            std::lock_guard<std::mutex> lock(*mutexes[i]);
+            AbstractMobileObj* pObj = objects[i];
+            Vector3D position = pObj->GetPositoin_m();
+            position.Axpy(1.0, shift);
+            pObj->SetPosition_m(position);
+            pObj->SetAng_Yaw_deg(pObj->GetAng_Yaw_deg() + 0.5);
+        }
+    };
+
+    NullChannel channel;
+    PerObjectUpdate perObject(count);
+    const double framePerObject = NsPerObject(count, repeats, [&] {
+        std::lock_guard<std::mutex> guard(channel.UseGuard());
+        step();
+        perObject.Run(store, scene.GetGraph(), mutexes, channel);
+    });
+    const double frameBatch = NsPerObject(count, repeats, [&] {
+        std::lock_guard<std::mutex> guard(channel.UseGuard());
+        step();
+        scene.PublishChanges(channel);
+    });
+    Report("frame", framePerObject, frameBatch);
+    cout << "  (" << channel.Updates << " updates published)" << endl;
+
+    // -- Operator chains of the vectors
+    double chainLoop, axpyLoop, normalizeLoop, chainExpr, axpyExpr, normalizeExpr;
+    VectorChains<LoopVector>(count, repeats, chainLoop, axpyLoop, normalizeLoop);
+    VectorChains<Vector3D>(count, repeats, chainExpr, axpyExpr, normalizeExpr);
+    cout << "  " << left << setw(16) << "" << right << setw(13) << "loops" << setw(13) << "Vector3D" << endl;
+    Report("a + b*s - c", chainLoop, chainExpr);
+    Report("axpy", axpyLoop, axpyExpr);
+    Report("normalize", normalizeLoop, normalizeExpr);
+
+    return 0;
+}
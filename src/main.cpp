@@ -1,6 +1,8 @@
 #include <iostream>
 #include <sstream>
 #include <memory>
+#include <list>
+#include <string>
 
 #include "xmlinterp.hh"
 #include "Set4LibInterfaces.hh"
@@ -16,16 +18,128 @@ using namespace std;
 using namespace xercesc;
 
 
+static void PrintUsage(const char* progName) {
+    std::cerr << "Usage: " << progName << " [-j <threads>] [-a <block|drop|coalesce>] [-w <text|binary>]"
+              << " [-q <shift_step>:<angle_step>] [-c <cache_file>] [-v]"
+              << " <config.xml> <commands.txt>" << std::endl;
+}
+
+
 int main(int argc, char* argv[]) {
-    if (argc < 3 || argc > 3) {
-        std::cerr << "Usage: " << argv[0] << " <config.xml> <commands.txt>" << std::endl;
+    unsigned int workerCount = 0;   // 0 - use the number of hardware threads
+    bool asyncSending = false;
+    BackpressurePolicy asyncPolicy = BackpressurePolicy::Coalesce;
+    WireFormat wireFormat = WireFormat::Text;
+    double shiftQuantum = 0, angleQuantum = 0;   // 0 - values are sent unrounded
+    bool verbose = false;
+    std::string cachePath;   // Empty - no program cache
+    std::list<std::string> args;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+
+        if (arg == "-j") {
+            if (i + 1 >= argc) {
+                PrintUsage(argv[0]);
+                return 1;
+            }
+            std::istringstream stream(argv[++i]);
+            long threads = 0;   // Signed, so that "-1" is rejected instead of wrapping around
+            char extra = 0;
+            if (!(stream >> threads) || stream >> extra || threads < 0 || threads > 1024) {
+                std::cerr << "Invalid number of threads: " << argv[i]
+                          << " (expected 0..1024, 0 - number of hardware threads)" << std::endl;
+                return 1;
+            }
+            workerCount = static_cast<unsigned int>(threads);
+            continue;
+        }
+
+        if (arg == "-a") {
+            if (i + 1 >= argc) {
+                PrintUsage(argv[0]);
+                return 1;
+            }
+            const std::string policy = argv[++i];
+            if (policy == "block") {
+                asyncPolicy = BackpressurePolicy::Block;
+            } else if (policy == "drop") {
+                asyncPolicy = BackpressurePolicy::DropOldest;
+            } else if (policy == "coalesce") {
+                asyncPolicy = BackpressurePolicy::Coalesce;
+            } else {
+                std::cerr << "Unknown backpressure policy: " << policy << std::endl;
+                return 1;
+            }
+            asyncSending = true;
+            continue;
+        }
+
+        if (arg == "-w") {
+            if (i + 1 >= argc) {
+                PrintUsage(argv[0]);
+                return 1;
+            }
+            const std::string format = argv[++i];
+            if (format == "text") {
+                wireFormat = WireFormat::Text;
+            } else if (format == "binary") {
+                wireFormat = WireFormat::Binary;
+            } else {
+                std::cerr << "Unknown wire format: " << format << std::endl;
+                return 1;
+            }
+            continue;
+        }
+
+        if (arg == "-q") {
+            if (i + 1 >= argc) {
+                PrintUsage(argv[0]);
+                return 1;
+            }
+            std::istringstream stream(argv[++i]);
+            char separator = 0;
+            if (!(stream >> shiftQuantum >> separator >> angleQuantum) || separator != ':'
+                || shiftQuantum < 0 || angleQuantum < 0) {
+                std::cerr << "Invalid quantization steps: " << argv[i] << std::endl;
+                return 1;
+            }
+            continue;
+        }
+
+        if (arg == "-c") {
+            if (i + 1 >= argc) {
+                PrintUsage(argv[0]);
+                return 1;
+            }
+            cachePath = argv[++i];
+            continue;
+        }
+
+        if (arg == "-v") {
+            verbose = true;
+            continue;
+        }
+
+        args.push_back(arg);
+    }
+
+    if (args.size() != 2) {
+        PrintUsage(argv[0]);
         return 1;
     }
 
-    const std::string configPath = argv[1];
-    const std::string commandsPath = argv[2];
+    const std::string configPath = args.front();
+    const std::string commandsPath = args.back();
 
-    ProgramInterpreter interpreter;
+    ProgramInterpreter interpreter(workerCount);
+    if (asyncSending) {
+        interpreter.EnableAsyncSending(asyncPolicy);
+    }
+    interpreter.SetWireFormat(wireFormat);
+    interpreter.SetQuantization(shiftQuantum, angleQuantum);
+    interpreter.SetVerbose(verbose);
+    interpreter.SetProgramCache(cachePath);
     if (!interpreter.Init(configPath, commandsPath)) {
         return 1;
     }
@@ -0,0 +1,342 @@
+/*!
+ * \file
+ * \brief Loopback stand-in for the graphical server.
+ *
+ * Accepts connections from the interpreter, decodes both the text
+ * commands and the binary records of BinaryProtocol.hh and reports,
+ * per connection, the received bytes, the decoded messages and the
+ * CPU time spent decoding them. Used to compare the wire formats:
+ * \code
+ *   ./wireserver &
+ *   ./interp -w binary config/config.xml cmd_list.txt
+ * \endcode
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include "BinaryProtocol.hh"
+
+using namespace std;
+
+
+/*!
+ * \brief Counters of a single connection.
+ */
+struct ConnectionStats {
+    bool Binary = false;              //!< The client sent the binary hello
+    std::uint64_t Bytes = 0;          //!< Received bytes
+    std::uint64_t AddObjs = 0;        //!< Decoded AddObj messages
+    std::uint64_t Updates = 0;        //!< Decoded UpdateObj messages
+    std::uint64_t Others = 0;         //!< Other commands
+    std::uint64_t Errors = 0;         //!< Malformed messages
+    double DecodeCpu_s = 0;           //!< CPU time spent decoding
+};
+
+
+/*!
+ * \brief Last state received for an object.
+ */
+struct ObjState {
+    double Shift[3] = {0, 0, 0};
+    double RotXYZ_deg[3] = {0, 0, 0};
+};
+
+
+/*!
+ * \brief Decodes the stream of a single connection.
+ */
+class StreamDecoder {
+private:
+    ConnectionStats& rStats;
+    bool Verbose;
+    bool Started = false;                               //!< The format has been detected
+    std::string Pending;                                //!< Received but not yet decoded bytes
+    std::unordered_map<std::uint32_t, std::string> Names;   //!< Id -> name (binary format)
+    std::unordered_map<std::string, ObjState> Objects;      //!< Name -> last state
+
+    /*!
+     * \brief Reads the triple following "Key=(" in a text command.
+     * \return False if the key is not present or the triple is malformed.
+     */
+    static bool ParseTriple(std::string_view line, std::string_view key, double* pValues) {
+        std::string pattern(key);
+        pattern += "=(";
+        const std::size_t at = line.find(pattern);
+        if (at == std::string_view::npos) return false;
+
+        std::string triple(line.substr(at + pattern.size()));
+        const char* p = triple.c_str();
+        for (int i = 0; i < 3; ++i) {
+            char* end;
+            pValues[i] = std::strtod(p, &end);
+            if (end == p) return false;
+            p = end + 1;    // Skip ',' or ')'
+        }
+        return true;
+    }
+
+    /*!
+     * \brief Decodes one text command.
+     */
+    void DecodeTextLine(std::string_view line) {
+        if (line.empty()) return;
+
+        const std::size_t nameAt = line.find("Name=");
+        std::string name;
+        if (nameAt != std::string_view::npos) {
+            const std::size_t nameEnd = line.find(' ', nameAt);
+            name = std::string(line.substr(nameAt + 5, nameEnd == std::string_view::npos ? std::string_view::npos
+                                                                                          : nameEnd - nameAt - 5));
+        }
+
+        if (line.compare(0, 7, "AddObj ") == 0 || line.compare(0, 10, "UpdateObj ") == 0) {
+            const bool add = line[0] == 'A';
+            ObjState& state = Objects[name];
+            ParseTriple(line, "Shift", state.Shift);
+            ParseTriple(line, "RotXYZ_deg", state.RotXYZ_deg);
+            ++(add ? rStats.AddObjs : rStats.Updates);
+        } else {
+            ++rStats.Others;
+        }
+
+        if (Verbose) cout << "  " << line << endl;
+    }
+
+    /*!
+     * \brief Decodes all complete text commands of Pending.
+     */
+    void DecodeText() {
+        std::size_t begin = 0;
+        for (;;) {
+            const std::size_t end = Pending.find('\n', begin);
+            if (end == std::string::npos) break;
+            DecodeTextLine(std::string_view(Pending).substr(begin, end - begin));
+            begin = end + 1;
+        }
+        Pending.erase(0, begin);
+    }
+
+    /*!
+     * \brief Decodes all complete binary records of Pending.
+     */
+    void DecodeBinary() {
+        std::size_t at = 0;
+        for (;;) {
+            const char* p = Pending.data() + at;
+            const std::size_t left = Pending.size() - at;
+            if (left < 8) break;
+
+            const auto type = static_cast<std::uint8_t>(p[0]);
+            if (type == wire::AddObjRecord) {
+                const std::size_t size = wire::AddObjSize + wire::GetU16(p + 2);
+                if (left < size) break;
+
+                std::string& name = Names[wire::GetU32(p + 4)];
+                name.assign(p + wire::AddObjSize, size - wire::AddObjSize);
+                ObjState& state = Objects[name];
+                for (int i = 0; i < 3; ++i) {
+                    state.Shift[i] = wire::GetF32(p + 20 + 4 * i);
+                    state.RotXYZ_deg[i] = wire::GetF32(p + 32 + 4 * i);
+                }
+                ++rStats.AddObjs;
+                if (Verbose) cout << "  AddObj #" << wire::GetU32(p + 4) << " " << name << endl;
+                at += size;
+            } else if (type == wire::UpdateObjRecord) {
+                if (left < wire::UpdateObjSize) break;
+
+                auto name = Names.find(wire::GetU32(p + 4));
+                if (name == Names.end()) {
+                    ++rStats.Errors;
+                } else {
+                    ObjState& state = Objects[name->second];
+                    const auto fields = static_cast<std::uint8_t>(p[1]);
+                    for (int i = 0; i < 3; ++i) {
+                        if (fields & ObjUpdate::HasShift) state.Shift[i] = wire::GetF32(p + 8 + 4 * i);
+                        if (fields & ObjUpdate::HasRotation) state.RotXYZ_deg[i] = wire::GetF32(p + 20 + 4 * i);
+                    }
+                    if (Verbose) {
+                        cout << "  UpdateObj " << name->second << " Shift=(" << state.Shift[0] << "," << state.Shift[1]
+                             << "," << state.Shift[2] << ") RotXYZ_deg=(" << state.RotXYZ_deg[0] << ","
+                             << state.RotXYZ_deg[1] << "," << state.RotXYZ_deg[2] << ")" << endl;
+                    }
+                }
+                ++rStats.Updates;
+                at += wire::UpdateObjSize;
+            } else if (type == wire::DeltaObjRecord) {
+                const auto mask = static_cast<std::uint8_t>(p[1]);
+                std::size_t size = wire::DeltaHeaderSize;
+                for (int i = 0; i < wire::DeltaFieldCount; ++i) {
+                    if (mask & (1u << i)) size += 4;
+                }
+                if (left < size) break;
+
+                auto name = Names.find(wire::GetU32(p + 4));
+                if (name == Names.end()) {
+                    ++rStats.Errors;
+                } else {
+                    ObjState& state = Objects[name->second];
+                    const char* value = p + wire::DeltaHeaderSize;
+                    for (int i = 0; i < wire::DeltaFieldCount; ++i) {
+                        if (!(mask & (1u << i))) continue;
+                        (i < 3 ? state.Shift[i] : state.RotXYZ_deg[i - 3]) = wire::GetF32(value);
+                        value += 4;
+                    }
+                    if (Verbose) {
+                        cout << "  DeltaObj " << name->second << " mask=" << static_cast<int>(mask)
+                             << " Shift=(" << state.Shift[0] << "," << state.Shift[1] << "," << state.Shift[2]
+                             << ") RotXYZ_deg=(" << state.RotXYZ_deg[0] << "," << state.RotXYZ_deg[1] << ","
+                             << state.RotXYZ_deg[2] << ")" << endl;
+                    }
+                }
+                ++rStats.Updates;
+                at += size;
+            } else if (type == wire::TextRecord) {
+                const std::size_t size = wire::TextHeaderSize + wire::GetU32(p + 4);
+                if (left < size) break;
+
+                std::string_view text(p + wire::TextHeaderSize, size - wire::TextHeaderSize);
+                while (!text.empty() && text.back() == '\n') text.remove_suffix(1);
+                DecodeTextLine(text);
+                at += size;
+            } else {
+                cerr << "Unknown record type " << static_cast<int>(type) << ", dropping the rest." << endl;
+                ++rStats.Errors;
+                at = Pending.size();
+            }
+        }
+        Pending.erase(0, at);
+    }
+
+public:
+    StreamDecoder(ConnectionStats& rConnStats, bool Verb) : rStats(rConnStats), Verbose(Verb) {}
+
+    /*!
+     * \brief Appends received bytes and decodes the complete messages.
+     */
+    void Feed(const char* pData, std::size_t Size) {
+        Pending.append(pData, Size);
+
+        if (!Started) {
+            if (Pending.size() < sizeof(wire::Magic)) return;
+
+            if (std::memcmp(Pending.data(), wire::Magic, sizeof(wire::Magic)) == 0) {
+                if (Pending.size() < wire::HelloSize) return;
+                if (static_cast<std::uint8_t>(Pending[4]) != wire::Version) {
+                    cerr << "Unsupported protocol version " << static_cast<int>(Pending[4]) << endl;
+                }
+                rStats.Binary = true;
+                Pending.erase(0, wire::HelloSize);
+            }
+            Started = true;
+        }
+
+        if (rStats.Binary) {
+            DecodeBinary();
+        } else {
+            DecodeText();
+        }
+    }
+};
+
+
+/*!
+ * \brief CPU time used by the calling thread, in seconds.
+ */
+static double ThreadCpuTime() {
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+
+/*!
+ * \brief Receives and decodes one connection, then prints its statistics.
+ */
+static void ServeConnection(int Socket, bool Verbose) {
+    ConnectionStats stats;
+    StreamDecoder decoder(stats, Verbose);
+    std::vector<char> buffer(64 * 1024);
+
+    const auto start = std::chrono::steady_clock::now();
+    for (;;) {
+        const ssize_t received = read(Socket, buffer.data(), buffer.size());
+        if (received <= 0) break;
+
+        stats.Bytes += received;
+        const double cpuStart = ThreadCpuTime();
+        decoder.Feed(buffer.data(), received);
+        stats.DecodeCpu_s += ThreadCpuTime() - cpuStart;
+    }
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const std::uint64_t messages = stats.AddObjs + stats.Updates + stats.Others;
+    cout << "Connection closed (" << (stats.Binary ? "binary" : "text") << " format)" << endl
+         << "  received:    " << stats.Bytes << " bytes in " << elapsed << " s" << endl
+         << "  messages:    " << messages << " (AddObj " << stats.AddObjs << ", UpdateObj " << stats.Updates
+         << ", other " << stats.Others << ", malformed " << stats.Errors << ")" << endl;
+    if (messages > 0) {
+        cout << "  bytes/msg:   " << static_cast<double>(stats.Bytes) / messages << endl
+             << "  decode CPU:  " << stats.DecodeCpu_s * 1e3 << " ms ("
+             << stats.DecodeCpu_s * 1e9 / messages << " ns/msg)" << endl;
+    }
+}
+
+
+int main(int argc, char* argv[]) {
+    int port = 6217;
+    bool verbose = false;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "-p" && i + 1 < argc) {
+            port = std::atoi(argv[++i]);
+        } else if (arg == "-v") {
+            verbose = true;
+        } else {
+            cerr << "Usage: " << argv[0] << " [-p <port>] [-v]" << endl;
+            return 1;
+        }
+    }
+
+    const int listener = socket(AF_INET, SOCK_STREAM, 0);
+    if (listener < 0) {
+        cerr << "*** Error opening socket." << endl;
+        return 1;
+    }
+
+    const int reuse = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = inet_addr("127.0.0.1");
+
+    if (bind(listener, (struct sockaddr*)&address, sizeof(address)) < 0 || listen(listener, 1) < 0) {
+        cerr << "*** Unable to listen on port " << port << ": " << strerror(errno) << endl;
+        close(listener);
+        return 1;
+    }
+
+    cout << "Listening on 127.0.0.1:" << port << endl;
+    for (;;) {
+        const int client = accept(listener, nullptr, nullptr);
+        if (client < 0) {
+            cerr << "*** Error accepting connection: " << strerror(errno) << endl;
+            continue;
+        }
+        ServeConnection(client, verbose);
+        close(client);
+    }
+}
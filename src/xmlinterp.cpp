@@ -1,9 +1,12 @@
 #include <xercesc/util/PlatformUtils.hpp>
 #include "xmlinterp.hh"
+#include "Logger.hh"
 #include <cassert>
-#include <sstream>
+#include <charconv>
 #include <cstdlib>
 #include <iostream>
+#include <string>
+#include <system_error>
 
 
 using namespace std;
@@ -20,7 +23,7 @@ XMLInterp4Config::XMLInterp4Config(Configuration &rConfig) : rConfig(rConfig) {}
  */
 void XMLInterp4Config::startDocument()
 {
-  cout << "*** Rozpoczecie przetwarzania dokumentu XML." << endl;
+  LOG_DEBUG("*** Rozpoczecie przetwarzania dokumentu XML.");
 }
 
 /*!
@@ -29,7 +32,70 @@ void XMLInterp4Config::startDocument()
  */
 void XMLInterp4Config::endDocument()
 {
-  cout << "=== Koniec przetwarzania dokumentu XML." << endl << endl << endl;
+  LOG_DEBUG("=== Koniec przetwarzania dokumentu XML.");
+}
+
+namespace {
+  /*
+   * Nazwy elementów i atrybutów w postaci XMLCh, przygotowane raz,
+   * aby nie wywoływać XMLString::transcode() dla każdego elementu.
+   */
+  const XMLCh xLib[]     = {'L','i','b',0};
+  const XMLCh xCube[]    = {'C','u','b','e',0};
+  const XMLCh xName[]    = {'N','a','m','e',0};
+  const XMLCh xScale[]   = {'S','c','a','l','e',0};
+  const XMLCh xShift[]   = {'S','h','i','f','t',0};
+  const XMLCh xRot[]     = {'R','o','t','X','Y','Z','_','d','e','g',0};
+  const XMLCh xTrans[]   = {'T','r','a','n','s','_','m',0};
+  const XMLCh xRGB[]     = {'R','G','B',0};
+
+  /*!
+   * \brief Zamienia napis XMLCh na std::string.
+   *
+   * Napisy ASCII są kopiowane bezpośrednio, pozostałe przekształca
+   * XMLString::transcode().
+   */
+  std::string ToString(const XMLCh* pText)
+  {
+    std::string Result;
+    for (const XMLCh* p = pText; *p; ++p) {
+      if (*p > 0x7f) {
+        char* sText = xercesc::XMLString::transcode(pText);
+        Result = sText;
+        xercesc::XMLString::release(&sText);
+        return Result;
+      }
+      Result += static_cast<char>(*p);
+    }
+    return Result;
+  }
+
+  /*!
+   * \brief Czyta trzy liczby rozdzielone białymi znakami bezpośrednio z napisu XMLCh.
+   * \retval true - odczytano trzy liczby i nic poza nimi,
+   * \retval false - w przypadku przeciwnym.
+   */
+  bool ParseVector(const XMLCh* pText, Vector3D& rVec)
+  {
+    const XMLCh* p = pText;
+    for (int i = 0; i < 3; ++i) {
+      while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r') ++p;
+
+      char Buffer[64];
+      std::size_t Length = 0;
+      while (*p && *p != ' ' && *p != '\t' && *p != '\n' && *p != '\r') {
+        if (*p > 0x7f || Length == sizeof(Buffer)) return false;
+        Buffer[Length++] = static_cast<char>(*p++);
+      }
+
+      const char* pBegin = Buffer;
+      if (Length > 1 && Buffer[0] == '+') ++pBegin;   // from_chars nie akceptuje znaku '+'
+      const auto Result = std::from_chars(pBegin, Buffer + Length, rVec[i]);
+      if (Length == 0 || Result.ec != std::errc() || Result.ptr != Buffer + Length) return false;
+    }
+    while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r') ++p;
+    return *p == 0;
+  }
 }
 
 /*!
@@ -39,99 +105,82 @@ void XMLInterp4Config::endDocument()
 void XMLInterp4Config::ProcessLibAttrs(const xercesc::Attributes  &rAttrs)
 {
     if (rAttrs.getLength() != 1) {
-        cerr << "Zla ilosc atrybutow dla \"Lib\"" << endl;
+        LOG_ERROR("Zla ilosc atrybutow dla \"Lib\"");
         exit(1);
     }
 
-    char* sParamName = xercesc::XMLString::transcode(rAttrs.getQName(0));
-
-    if (strcmp(sParamName,"Name")) {
-        cerr << "Zla nazwa atrybutu dla Lib" << endl;
+    if (!xercesc::XMLString::equals(rAttrs.getLocalName(0), xName)) {
+        LOG_ERROR("Zla nazwa atrybutu dla Lib");
         exit(1);
-    }         
-
-    XMLSize_t  Size = 0;
-    char* sLibName = xercesc::XMLString::transcode(rAttrs.getValue(Size));
+    }
 
-    cout << "  Nazwa biblioteki: " << sLibName << endl;
+    const std::string LibName = ToString(rAttrs.getValue(XMLSize_t(0)));
 
-    rConfig.AddLib(sLibName);
+    LOG_DEBUG("  Nazwa biblioteki: " << LibName);
 
-    xercesc::XMLString::release(&sParamName);
-    xercesc::XMLString::release(&sLibName);
+    rConfig.AddLib(LibName);
 }
 
 /*!
  * Analizuje atrybuty. Sprawdza czy ich nazwy są poprawne. Jeśli tak,
- * to pobiera wartości atrybutów (w postaci napisów) i przekazuje ...
+ * to odczytuje ich wartości bezpośrednio z napisów XMLCh, bez
+ * pośrednich napisów i strumieni, i dodaje opis prostopadłościanu
+ * do konfiguracji. Brak nazwy lub błędna wartość wektora jest błędem
+ * konfiguracji i kończy program, tak jak błędy elementu \p "Lib".
  * \param[in] rAttrs - atrybuty elementu XML \p "Cube".
  */
 void XMLInterp4Config::ProcessCubeAttrs(const xercesc::Attributes  &rAttrs)
 {
     if (rAttrs.getLength() < 1) {
-        cerr << "Zla ilosc atrybutow dla \"Cube\"" << endl;
+        LOG_ERROR("Zla ilosc atrybutow dla \"Cube\"");
         exit(1);
     }
 
-    XMLCh* xmlName = xercesc::XMLString::transcode("Name");
-    XMLCh* xmlScale = xercesc::XMLString::transcode("Scale");
-    XMLCh* xmlShift = xercesc::XMLString::transcode("Shift");
-    XMLCh* xmlRot = xercesc::XMLString::transcode("RotXYZ_deg");
-    XMLCh* xmlTrans = xercesc::XMLString::transcode("Trans_m");
-    XMLCh* xmlRGB = xercesc::XMLString::transcode("RGB");
-
-    char* sName = nullptr;
-    char* sScale = nullptr;
-    char* sShift = nullptr;
-    char* sRot = nullptr;
-    char* sTrans = nullptr;
-    char* sRGB = nullptr;
-
-    try {
-        // Get attribute values
-        sName = xercesc::XMLString::transcode(rAttrs.getValue(xmlName));
-        sScale = xercesc::XMLString::transcode(rAttrs.getValue(xmlScale));
-        sShift = xercesc::XMLString::transcode(rAttrs.getValue(xmlShift));
-        sRot = xercesc::XMLString::transcode(rAttrs.getValue(xmlRot));
-        sTrans = xercesc::XMLString::transcode(rAttrs.getValue(xmlTrans));
-        sRGB = xercesc::XMLString::transcode(rAttrs.getValue(xmlRGB));
-
-        // Parse attributes into Vector3D objects
-        Vector3D scale, shift, rotation, translation, rgb;
-        std::istringstream(sScale) >> scale[0] >> scale[1] >> scale[2];
-        std::istringstream(sShift) >> shift[0] >> shift[1] >> shift[2];
-        std::istringstream(sRot) >> rotation[0] >> rotation[1] >> rotation[2];
-        std::istringstream(sTrans) >> translation[0] >> translation[1] >> translation[2];
-        std::istringstream(sRGB) >> rgb[0] >> rgb[1] >> rgb[2];
-
-        // Debug: Output parsed values
-        std::cout << "Parsed Cube:" << std::endl;
-        std::cout << "  Name: " << sName << std::endl;
-        std::cout << "  Scale: " << scale << std::endl;
-        std::cout << "  Shift: " << shift << std::endl;
-        std::cout << "  Rotation: " << rotation << std::endl;
-        std::cout << "  Translation: " << translation << std::endl;
-        std::cout << "  RGB: " << rgb << std::endl;
-
-        // Add CubeConfig to Configuration
-        rConfig.AddCube(CubeConfig(sName, scale, shift, rotation, translation, rgb));
-        
-    } catch (...) {
-        std::cerr << "Error processing Cube attributes.\n";
+    CubeConfig Cube;
+    bool HasName = false, Ok = true;
+    const XMLCh* pBadAttr = nullptr;
+
+    // Jedno przejście po atrybutach zamiast wyszukiwania każdego z nich osobno
+    for (XMLSize_t i = 0; Ok && i < rAttrs.getLength(); ++i) {
+        const XMLCh* pAttrName = rAttrs.getLocalName(i);
+        const XMLCh* pValue = rAttrs.getValue(i);
+
+        if (xercesc::XMLString::equals(pAttrName, xName)) {
+            Cube.Name = ToString(pValue);
+            HasName = true;
+        } else if (xercesc::XMLString::equals(pAttrName, xScale)) {
+            Ok = ParseVector(pValue, Cube.Scale);
+        } else if (xercesc::XMLString::equals(pAttrName, xShift)) {
+            Ok = ParseVector(pValue, Cube.Shift);
+        } else if (xercesc::XMLString::equals(pAttrName, xRot)) {
+            Ok = ParseVector(pValue, Cube.Rotation);
+        } else if (xercesc::XMLString::equals(pAttrName, xTrans)) {
+            Ok = ParseVector(pValue, Cube.Translation);
+        } else if (xercesc::XMLString::equals(pAttrName, xRGB)) {
+            Ok = ParseVector(pValue, Cube.RGB);
+        }
+        if (!Ok) pBadAttr = pAttrName;
     }
 
-    xercesc::XMLString::release(&xmlName);
-    xercesc::XMLString::release(&xmlScale);
-    xercesc::XMLString::release(&xmlShift);
-    xercesc::XMLString::release(&xmlRot);
-    xercesc::XMLString::release(&xmlTrans);
-    xercesc::XMLString::release(&xmlRGB);
-    xercesc::XMLString::release(&sName);
-    xercesc::XMLString::release(&sScale);
-    xercesc::XMLString::release(&sShift);
-    xercesc::XMLString::release(&sRot);
-    xercesc::XMLString::release(&sTrans);
-    xercesc::XMLString::release(&sRGB);
+    if (!Ok) {
+        LOG_ERROR("Zla wartosc atrybutu \"" << ToString(pBadAttr) << "\" dla \"Cube\""
+                  << (HasName ? " " + Cube.Name : std::string()));
+        exit(1);
+    }
+    if (!HasName) {
+        LOG_ERROR("Brak atrybutu \"Name\" dla \"Cube\"");
+        exit(1);
+    }
+
+    LOG_DEBUG("Parsed Cube:\n"
+              << "  Name: " << Cube.Name << "\n"
+              << "  Scale: " << Cube.Scale << "\n"
+              << "  Shift: " << Cube.Shift << "\n"
+              << "  Rotation: " << Cube.Rotation << "\n"
+              << "  Translation: " << Cube.Translation << "\n"
+              << "  RGB: " << Cube.RGB);
+
+    rConfig.AddCube(Cube);
 }
 
 
@@ -142,21 +191,20 @@ void XMLInterp4Config::ProcessCubeAttrs(const xercesc::Attributes  &rAttrs)
 
 /*!
  * Wykonuje operacje związane z wystąpieniem danego elementu XML.
- * W przypadku elementu \p "Action" będzie to utworzenie obiektu
- * reprezentującego odpowiednią działanie robota.
- * W przypadku elementu \p "Parameter" będzie to zapisanie parametrów
- * związanych z danym działaniem.
- * \param[in] rElemName - nazwa elementu XML.
+ * W przypadku elementu \p "Lib" będzie to dodanie biblioteki
+ * do konfiguracji, a w przypadku elementu \p "Cube" dodanie
+ * opisu prostopadłościanu.
+ * \param[in] pElemName - nazwa elementu XML.
  * \param[in] rAttrs - atrybuty napotkanego elementu XML.
  */
-void XMLInterp4Config::WhenStartElement( const std::string &rElemName, const xercesc::Attributes &rAttrs)
+void XMLInterp4Config::WhenStartElement( const XMLCh *pElemName, const xercesc::Attributes &rAttrs)
 {
-    if (rElemName == "Lib") {
-        ProcessLibAttrs(rAttrs);   return;   
+    if (xercesc::XMLString::equals(pElemName, xCube)) {
+        ProcessCubeAttrs(rAttrs);  return;
     }
 
-    if (rElemName == "Cube") {
-        ProcessCubeAttrs(rAttrs);  return;
+    if (xercesc::XMLString::equals(pElemName, xLib)) {
+        ProcessLibAttrs(rAttrs);   return;
     }
 }
 
@@ -193,12 +241,13 @@ void XMLInterp4Config::startElement(  const   XMLCh* const            pURI,
 				      const   xercesc::Attributes&    rAttrs
                                     )
 {
-    char* sElemName = xercesc::XMLString::transcode(pLocalName);
-    cout << "+++ Poczatek elementu: "<< sElemName << endl;
-
-    WhenStartElement(sElemName, rAttrs);
+    if (LOG_IS_ENABLED(APM_LOG_TRACE)) {
+      char* sElemName = xercesc::XMLString::transcode(pLocalName);
+      LOG_TRACE("+++ Poczatek elementu: " << sElemName);
+      xercesc::XMLString::release(&sElemName);
+    }
 
-    xercesc::XMLString::release(&sElemName);
+    WhenStartElement(pLocalName, rAttrs);
 }
 
 
@@ -235,14 +284,18 @@ void XMLInterp4Config::endElement(  const   XMLCh* const    pURI,
                                     const   XMLCh* const    pQName
                                  )
 {
+   if (!LOG_IS_ENABLED(APM_LOG_TRACE)) return;
+
    char* sURI =  xercesc::XMLString::transcode(pURI);
    char* sElemName = xercesc::XMLString::transcode(pLocalName);
    char* sQName =  xercesc::XMLString::transcode(pQName);
-   cout << "   URI: " << sURI << endl;
-   cout << " QName: " << sQName << endl;
-   cout << "----- Koniec elementu: "<< sElemName << endl;
+   LOG_TRACE("   URI: " << sURI << "\n"
+             << " QName: " << sQName << "\n"
+             << "----- Koniec elementu: " << sElemName);
 
+   xercesc::XMLString::release(&sURI);
    xercesc::XMLString::release(&sElemName);
+   xercesc::XMLString::release(&sQName);
 }
 
 
@@ -263,12 +316,11 @@ void XMLInterp4Config::fatalError(const xercesc::SAXParseException&  rException)
    char* sMessage = xercesc::XMLString::transcode(rException.getMessage());
    char* sSystemId = xercesc::XMLString::transcode(rException.getSystemId());
 
-   cerr << "Blad fatalny! " << endl
-        << "    Plik:  " << sSystemId << endl
-        << "   Linia: " << rException.getLineNumber() << endl
-        << " Kolumna: " << rException.getColumnNumber() << endl
-        << " Informacja: " << sMessage 
-        << endl;
+   LOG_ERROR("Blad fatalny! " << "\n"
+             << "    Plik:  " << sSystemId << "\n"
+             << "   Linia: " << rException.getLineNumber() << "\n"
+             << " Kolumna: " << rException.getColumnNumber() << "\n"
+             << " Informacja: " << sMessage);
 
    xercesc::XMLString::release(&sMessage);
    xercesc::XMLString::release(&sSystemId);
@@ -284,7 +336,7 @@ void XMLInterp4Config::fatalError(const xercesc::SAXParseException&  rException)
  */
 void XMLInterp4Config::error(const xercesc::SAXParseException&  rException)
 {
-  cerr << "Blad ..." << endl;
+  LOG_ERROR("Blad ...");
 
   /*
    * Tutaj należy wstawić odpowiedni kod. Tekst wyświetlany powyżej
@@ -301,7 +353,7 @@ void XMLInterp4Config::error(const xercesc::SAXParseException&  rException)
  */
 void XMLInterp4Config::warning(const xercesc::SAXParseException&  rException)  
 {
-  cerr << "Ostrzezenie ..." << endl;
+  LOG_WARN("Ostrzezenie ...");
 
   /*
    * Tutaj należy wstawić odpowiedni kod. Tekst wyświetlany powyżej